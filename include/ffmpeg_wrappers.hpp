@@ -145,9 +145,10 @@ inline void check_error(int ret, std::string_view message) {
 }
 
 // Factory functions
-inline FormatContextPtr open_input_format(const char *filename) {
+inline FormatContextPtr open_input_format(const char *filename,
+                                          AVDictionary **options = nullptr) {
   AVFormatContext *raw_ctx = nullptr;
-  int ret = avformat_open_input(&raw_ctx, filename, nullptr, nullptr);
+  int ret = avformat_open_input(&raw_ctx, filename, nullptr, options);
   if (ret < 0) {
     throw FFmpegError(ret);
   }
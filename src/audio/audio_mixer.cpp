@@ -7,13 +7,33 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+extern "C" {
+#include <libavutil/cpu.h>
+}
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <filesystem>
 #include <format>
-#include <fstream>
 #include <iostream>
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace fs = std::filesystem;
 
 namespace {
@@ -33,10 +53,11 @@ struct WAVHeader {
   uint16_t bits_per_sample;
   char data_header[4] = {'d', 'a', 't', 'a'};
   uint32_t data_bytes;
-};
+} __attribute__((packed));
+
+static_assert(sizeof(WAVHeader) == 44, "WAV header must be written unpadded");
 
-void write_wav_header(std::ofstream &file, int sample_rate, int channels,
-                      uint32_t data_size) {
+WAVHeader make_wav_header(int sample_rate, int channels, uint32_t data_size) {
   WAVHeader header;
   header.num_channels = static_cast<uint16_t>(channels);
   header.sample_rate = static_cast<uint32_t>(sample_rate);
@@ -45,10 +66,336 @@ void write_wav_header(std::ofstream &file, int sample_rate, int channels,
   header.block_align = static_cast<uint16_t>(channels * 2);
   header.data_bytes = data_size;
   header.wav_size = 36 + data_size;
+  return header;
+}
 
-  file.write(reinterpret_cast<const char *>(&header), sizeof(WAVHeader));
+// Minimal 64-byte-aligned allocator so chunk buffers line up with cache
+// lines and the mix kernels can use aligned vector loads/stores.
+template <typename T, std::size_t Alignment> struct AlignedAlloc {
+  using value_type = T;
+
+  AlignedAlloc() = default;
+  template <typename U>
+  AlignedAlloc(const AlignedAlloc<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+  }
+  void deallocate(T *p, std::size_t n) noexcept {
+    ::operator delete(p, n * sizeof(T), std::align_val_t{Alignment});
+  }
+
+  // resize() value-initializes through the allocator; slot contents are
+  // always overwritten by decode/mix before being read, so default-
+  // initialize instead and skip the O(N) memset per buffer.
+  template <typename U> void construct(U *) noexcept {}
+  template <typename U, typename... Args> void construct(U *p, Args &&...args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+
+  template <typename U> struct rebind {
+    using other = AlignedAlloc<U, Alignment>;
+  };
+  friend bool operator==(const AlignedAlloc &, const AlignedAlloc &) {
+    return true;
+  }
+};
+
+using SampleBuffer = std::vector<int16_t, AlignedAlloc<int16_t, 64>>;
+
+// Mix two interleaved S16 buffers into `out` with Q15 gains. The SIMD
+// variants use mulhrs (rounding Q15 multiply) plus a saturating add,
+// which replaces the scalar float multiply + int32 clamp per sample;
+// saturation comes for free from adds_epi16. Gains are capped at 1.0
+// upstream, so Q15 cannot overflow the multiply. The widest variant
+// supported by the running CPU is selected once via av_get_cpu_flags(),
+// the same way libavcodec's audiodsp init picks its asm. The vector
+// variants use aligned loads/stores: every caller passes ring-slot
+// starts, which SampleBuffer keeps on 64-byte boundaries.
+using mix_fn = void (*)(const int16_t *, const int16_t *, int16_t *,
+                        std::size_t, int16_t, int16_t);
+
+void mix_s16_scalar(const int16_t *in1, const int16_t *in2, int16_t *out,
+                    std::size_t n, int16_t vol1_q15, int16_t vol2_q15) {
+  for (std::size_t i = 0; i < n; ++i) {
+    auto mixed = static_cast<int32_t>((in1[i] * vol1_q15 + (1 << 14)) >> 15) +
+                 static_cast<int32_t>((in2[i] * vol2_q15 + (1 << 14)) >> 15);
+    // Branchless saturate to S16: only when the sum overflows 16 bits,
+    // replace it with 0x7FFF or -0x8000 derived from its sign bit.
+    if (mixed != static_cast<int16_t>(mixed)) {
+      mixed = (mixed >> 31) ^ 0x7FFF;
+    }
+    out[i] = static_cast<int16_t>(mixed);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Baseline x86-64 (no SSSE3 mulhrs): interleave the two inputs and use
+// pmaddwd with a packed [v1,v2] coefficient, so each int32 lane holds
+// s1*v1 + s2*v2; packssdw saturates back to int16. One madd replaces a
+// mulhrs+mulhrs+add triple, and the same interleave/dot-product shape
+// extends to N-to-1 mixing by accumulating further source pairs into
+// the int32 lanes before the shift/pack.
+__attribute__((target("sse2"))) void
+mix_s16_sse2(const int16_t *in1, const int16_t *in2, int16_t *out,
+             std::size_t n, int16_t vol1_q15, int16_t vol2_q15) {
+  std::size_t i = 0;
+  const __m128i coef = _mm_set1_epi32(
+      (static_cast<std::uint32_t>(static_cast<std::uint16_t>(vol2_q15))
+       << 16) |
+      static_cast<std::uint16_t>(vol1_q15));
+  for (; i + 8 <= n; i += 8) {
+    const __m128i a =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(in1 + i));
+    const __m128i b =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(in2 + i));
+    const __m128i lo =
+        _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), coef), 15);
+    const __m128i hi =
+        _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), coef), 15);
+    _mm_store_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+  mix_s16_scalar(in1 + i, in2 + i, out + i, n - i, vol1_q15, vol2_q15);
+}
+
+__attribute__((target("ssse3"))) void
+mix_s16_ssse3(const int16_t *in1, const int16_t *in2, int16_t *out,
+              std::size_t n, int16_t vol1_q15, int16_t vol2_q15) {
+  std::size_t i = 0;
+  const __m128i v1 = _mm_set1_epi16(vol1_q15);
+  const __m128i v2 = _mm_set1_epi16(vol2_q15);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i a =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(in1 + i));
+    const __m128i b =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(in2 + i));
+    const __m128i mixed =
+        _mm_adds_epi16(_mm_mulhrs_epi16(a, v1), _mm_mulhrs_epi16(b, v2));
+    _mm_store_si128(reinterpret_cast<__m128i *>(out + i), mixed);
+  }
+  mix_s16_scalar(in1 + i, in2 + i, out + i, n - i, vol1_q15, vol2_q15);
 }
 
+__attribute__((target("avx2"))) void
+mix_s16_avx2(const int16_t *in1, const int16_t *in2, int16_t *out,
+             std::size_t n, int16_t vol1_q15, int16_t vol2_q15) {
+  std::size_t i = 0;
+  const __m256i v1 = _mm256_set1_epi16(vol1_q15);
+  const __m256i v2 = _mm256_set1_epi16(vol2_q15);
+  for (; i + 16 <= n; i += 16) {
+    const __m256i a =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(in1 + i));
+    const __m256i b =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(in2 + i));
+    const __m256i mixed = _mm256_adds_epi16(_mm256_mulhrs_epi16(a, v1),
+                                            _mm256_mulhrs_epi16(b, v2));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(out + i), mixed);
+  }
+  mix_s16_scalar(in1 + i, in2 + i, out + i, n - i, vol1_q15, vol2_q15);
+}
+
+// 32 samples per iteration; the remainder is handled with a masked
+// store instead of a scalar epilogue.
+__attribute__((target("avx512f,avx512bw"))) void
+mix_s16_avx512(const int16_t *in1, const int16_t *in2, int16_t *out,
+               std::size_t n, int16_t vol1_q15, int16_t vol2_q15) {
+  std::size_t i = 0;
+  const __m512i v1 = _mm512_set1_epi16(vol1_q15);
+  const __m512i v2 = _mm512_set1_epi16(vol2_q15);
+  for (; i + 32 <= n; i += 32) {
+    const __m512i a = _mm512_load_si512(in1 + i);
+    const __m512i b = _mm512_load_si512(in2 + i);
+    const __m512i mixed = _mm512_adds_epi16(_mm512_mulhrs_epi16(a, v1),
+                                            _mm512_mulhrs_epi16(b, v2));
+    _mm512_store_si512(out + i, mixed);
+  }
+  if (i < n) {
+    const auto rem = static_cast<unsigned>(n - i);
+    const __mmask32 m = _cvtu32_mask32((1u << rem) - 1);
+    const __m512i a = _mm512_maskz_loadu_epi16(m, in1 + i);
+    const __m512i b = _mm512_maskz_loadu_epi16(m, in2 + i);
+    const __m512i mixed = _mm512_adds_epi16(_mm512_mulhrs_epi16(a, v1),
+                                            _mm512_mulhrs_epi16(b, v2));
+    _mm512_mask_storeu_epi16(out + i, m, mixed);
+  }
+}
+
+#elif defined(__ARM_NEON)
+
+void mix_s16_neon(const int16_t *in1, const int16_t *in2, int16_t *out,
+                  std::size_t n, int16_t vol1_q15, int16_t vol2_q15) {
+  std::size_t i = 0;
+  const int16x8_t v1 = vdupq_n_s16(vol1_q15);
+  const int16x8_t v2 = vdupq_n_s16(vol2_q15);
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t a = vld1q_s16(in1 + i);
+    const int16x8_t b = vld1q_s16(in2 + i);
+    const int16x8_t mixed =
+        vqaddq_s16(vqrdmulhq_s16(a, v1), vqrdmulhq_s16(b, v2));
+    vst1q_s16(out + i, mixed);
+  }
+  mix_s16_scalar(in1 + i, in2 + i, out + i, n - i, vol1_q15, vol2_q15);
+}
+
+#endif
+
+// Pick the widest variant the running CPU supports, once.
+mix_fn select_mix_fn() {
+  const int flags = av_get_cpu_flags();
+#if defined(__x86_64__) || defined(__i386__)
+  if (flags & AV_CPU_FLAG_AVX512) {
+    return mix_s16_avx512;
+  }
+  if (flags & AV_CPU_FLAG_AVX2) {
+    return mix_s16_avx2;
+  }
+  if (flags & AV_CPU_FLAG_SSSE3) {
+    return mix_s16_ssse3;
+  }
+  if (flags & AV_CPU_FLAG_SSE2) {
+    return mix_s16_sse2;
+  }
+#elif defined(__ARM_NEON)
+  if (flags & AV_CPU_FLAG_NEON) {
+    return mix_s16_neon;
+  }
+#else
+  (void)flags;
+#endif
+  return mix_s16_scalar;
+}
+
+const mix_fn mix_s16 = select_mix_fn();
+
+// Scale a run of S16 samples by a Q15 gain into `out`; this is the
+// whole per-chunk work once one source has hit EOF, so it gets the same
+// runtime dispatch as the mix kernel. Unlike the mix, it is entered at
+// arbitrary offsets (nmin), hence unaligned loads. No saturation
+// needed: |gain| <= 1.
+using scale_fn = void (*)(const int16_t *, int16_t *, std::size_t, int16_t);
+
+void scale_s16_scalar(const int16_t *in, int16_t *out, std::size_t n,
+                      int16_t vol_q15) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<int16_t>((in[i] * vol_q15 + (1 << 14)) >> 15);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("ssse3"))) void
+scale_s16_ssse3(const int16_t *in, int16_t *out, std::size_t n,
+                int16_t vol_q15) {
+  std::size_t i = 0;
+  const __m128i v = _mm_set1_epi16(vol_q15);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_mulhrs_epi16(a, v));
+  }
+  scale_s16_scalar(in + i, out + i, n - i, vol_q15);
+}
+
+__attribute__((target("avx2"))) void
+scale_s16_avx2(const int16_t *in, int16_t *out, std::size_t n,
+               int16_t vol_q15) {
+  std::size_t i = 0;
+  const __m256i v = _mm256_set1_epi16(vol_q15);
+  for (; i + 16 <= n; i += 16) {
+    const __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm256_mulhrs_epi16(a, v));
+  }
+  scale_s16_scalar(in + i, out + i, n - i, vol_q15);
+}
+
+#endif
+
+scale_fn select_scale_fn() {
+  const int flags = av_get_cpu_flags();
+#if defined(__x86_64__) || defined(__i386__)
+  if (flags & AV_CPU_FLAG_AVX2) {
+    return scale_s16_avx2;
+  }
+  if (flags & AV_CPU_FLAG_SSSE3) {
+    return scale_s16_ssse3;
+  }
+#else
+  (void)flags;
+#endif
+  return scale_s16_scalar;
+}
+
+const scale_fn scale_s16 = select_scale_fn();
+
+// Fixed-depth SPSC queue of decoded S16 chunks feeding the mix loop.
+// One decoder thread produces, the mix loop consumes; head/tail indices
+// are the only shared state, so acquire/release atomics plus a yield
+// spin are enough (a chunk is ~743 ms of audio, so spins are rare).
+class ChunkQueue {
+public:
+  struct Chunk {
+    SampleBuffer samples;
+    int sample_count = 0; // per-channel samples valid in `samples`
+  };
+
+  explicit ChunkQueue(std::size_t chunk_values) {
+    // Pad to a whole number of 64-byte lines so vector loops can run to
+    // the rounded-up bound without a partial last line.
+    const auto padded = (chunk_values + 31) / 32 * 32;
+    for (auto &slot : slots_) {
+      slot.samples.resize(padded);
+    }
+  }
+
+  // Producer: slot to decode into, blocking while the ring is full.
+  Chunk &producer_slot() {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    while ((tail + 1) % kDepth == head_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    return slots_[tail];
+  }
+
+  void publish() {
+    tail_.store((tail_.load(std::memory_order_relaxed) + 1) % kDepth,
+                std::memory_order_release);
+  }
+
+  void finish() { done_.store(true, std::memory_order_release); }
+
+  // Consumer: next filled chunk, or nullptr once the producer finished
+  // and the ring drained.
+  Chunk *acquire() {
+    const auto head = head_.load(std::memory_order_relaxed);
+    while (head == tail_.load(std::memory_order_acquire)) {
+      if (done_.load(std::memory_order_acquire) &&
+          head == tail_.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      std::this_thread::yield();
+    }
+    return &slots_[head];
+  }
+
+  void release() {
+    head_.store((head_.load(std::memory_order_relaxed) + 1) % kDepth,
+                std::memory_order_release);
+  }
+
+private:
+  static constexpr std::size_t kDepth = 4;
+  std::array<Chunk, kDepth> slots_;
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<bool> done_{false};
+};
+
 class AudioDecoder {
 public:
   AudioDecoder(std::string_view filename, int target_sample_rate,
@@ -103,6 +450,14 @@ public:
 
   bool is_eof() const { return eof_; }
 
+  // Container duration in seconds (0 when unknown); used to size the
+  // output preallocation.
+  double duration_seconds() const {
+    return format_ctx_->duration > 0
+               ? format_ctx_->duration / static_cast<double>(AV_TIME_BASE)
+               : 0.0;
+  }
+
 private:
   void initialize(int target_sample_rate, int target_channels) {
     // Find audio stream
@@ -135,6 +490,11 @@ private:
       out_ch_layout = AV_CHANNEL_LAYOUT_STEREO;
     }
 
+    // S16 interleaved is requested here deliberately: either way swr
+    // converts the decoder's native format exactly once, and converting
+    // on the decode side keeps the mix in the Q15 integer kernels
+    // (mulhrs + saturating add) instead of a float FMA pass that would
+    // still need a clip + pack back to S16 before write-out.
     ffmpeg::check_error(
         swr_alloc_set_opts2(&swr_ctx_raw_, &out_ch_layout, AV_SAMPLE_FMT_S16,
                             target_sample_rate, &codec_ctx_->ch_layout,
@@ -164,11 +524,10 @@ public:
              const fs::path &output, float volume1, float volume2)
       : output_file_(output), volume1_(std::clamp(volume1, 0.0f, 1.0f)),
         volume2_(std::clamp(volume2, 0.0f, 1.0f)),
+        vol1_q15_(static_cast<int16_t>(std::lround(volume1_ * 32767.0f))),
+        vol2_q15_(static_cast<int16_t>(std::lround(volume2_ * 32767.0f))),
         decoder1_(input1, target_sample_rate_, target_channels_),
-        decoder2_(input2, target_sample_rate_, target_channels_),
-        buffer1_(buffer_size_ * target_channels_),
-        buffer2_(buffer_size_ * target_channels_),
-        output_buffer_(buffer_size_ * target_channels_) {}
+        decoder2_(input2, target_sample_rate_, target_channels_) {}
 
   void mix() {
     std::cout << "Audio Mixer\n";
@@ -179,68 +538,147 @@ public:
     std::cout << std::format("Volume 1: {:.2f}\n", volume1_);
     std::cout << std::format("Volume 2: {:.2f}\n\n", volume2_);
 
-    // Open output file
-    std::ofstream output_stream(output_file_, std::ios::binary);
-    if (!output_stream.is_open()) {
+    // Create the file through a raw fd first: preallocate the estimated
+    // size so sequential writes never stall on extent allocation, and
+    // keep the fd around so the final header patch can go through
+    // pwrite(2) instead of seeking the active stream.
+    const int out_fd =
+        ::open(output_file_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
       throw std::runtime_error(
-          std::format("Failed to open output file: {}", output_file_.string()));
+          std::format("Failed to create output file: {}", output_file_.string()));
+    }
+    const auto est_seconds =
+        std::max(decoder1_.duration_seconds(), decoder2_.duration_seconds());
+    const auto est_bytes =
+        static_cast<off_t>(sizeof(WAVHeader)) +
+        static_cast<off_t>(est_seconds * target_sample_rate_) *
+            target_channels_ * static_cast<off_t>(sizeof(int16_t));
+    if (est_bytes > static_cast<off_t>(sizeof(WAVHeader))) {
+      posix_fallocate(out_fd, 0, est_bytes); // best effort
     }
 
-    // Write placeholder WAV header
-    write_wav_header(output_stream, target_sample_rate_, target_channels_, 0);
+    // No placeholder header write: just park the fd position at the data
+    // chunk. The real header lands once via pwrite() at the end, and the
+    // gap reads as zeros either way (fallocate or file hole).
+    lseek(out_fd, sizeof(WAVHeader), SEEK_SET);
 
     uint32_t total_samples_written = 0;
-    int iteration = 0;
+    auto last_progress = std::chrono::steady_clock::now();
 
     std::cout << "Mixing in progress...\n";
 
-    // Mix audio
-    while (!decoder1_.is_eof() || !decoder2_.is_eof()) {
-      const auto samples1 =
-          decoder1_.read_samples(buffer1_.data(), buffer_size_);
-      const auto samples2 =
-          decoder2_.read_samples(buffer2_.data(), buffer_size_);
-
-      const auto max_samples = std::max(samples1, samples2);
+    // Decode the two inputs on their own threads; the contexts are
+    // independent, so demux + decode + resample of both files overlap
+    // with each other and with the mix/write below.
+    ChunkQueue queue1(static_cast<std::size_t>(buffer_size_) *
+                      target_channels_);
+    ChunkQueue queue2(static_cast<std::size_t>(buffer_size_) *
+                      target_channels_);
+
+    const auto decode_worker = [](AudioDecoder &decoder, ChunkQueue &queue) {
+      for (;;) {
+        auto &slot = queue.producer_slot();
+        // swr_convert resamples straight into ring-slot memory; there is
+        // no intermediate decode buffer between the decoder and the mix.
+        const auto n = decoder.read_samples(slot.samples.data(), buffer_size_);
+        if (n <= 0) {
+          break;
+        }
+        slot.sample_count = n;
+        queue.publish();
+      }
+      queue.finish();
+    };
+
+    std::thread worker1(decode_worker, std::ref(decoder1_), std::ref(queue1));
+    std::thread worker2(decode_worker, std::ref(decoder2_), std::ref(queue2));
+
+    // Mixed chunks go through a second ring to a writer thread, so while
+    // chunk N is being mixed, chunk N-1 is hitting the file and chunk
+    // N+1 is being decoded. The ring's slots double-buffer the output,
+    // replacing the single output_buffer_.
+    ChunkQueue write_queue(static_cast<std::size_t>(buffer_size_) *
+                           target_channels_);
+    std::thread writer([&write_queue, out_fd] {
+      while (auto *chunk = write_queue.acquire()) {
+        ::write(out_fd, chunk->samples.data(),
+                static_cast<std::size_t>(chunk->sample_count) *
+                    target_channels_ * sizeof(int16_t));
+        write_queue.release();
+      }
+    });
 
-      if (max_samples == 0) {
+    // Mix audio
+    for (;;) {
+      auto *chunk1 = queue1.acquire();
+      auto *chunk2 = queue2.acquire();
+      if (!chunk1 && !chunk2) {
         break;
       }
 
-      // Mix samples
-      for (int i = 0; i < max_samples * target_channels_; ++i) {
-        const auto sample1 =
-            (i < samples1 * target_channels_) ? buffer1_[i] : int16_t{0};
-        const auto sample2 =
-            (i < samples2 * target_channels_) ? buffer2_[i] : int16_t{0};
-
-        // Mix with volume control and clipping prevention
-        auto mixed = static_cast<int32_t>(sample1 * volume1_) +
-                     static_cast<int32_t>(sample2 * volume2_);
-
-        // Clamp to prevent overflow
-        mixed = std::clamp(mixed, static_cast<int32_t>(-32768),
-                           static_cast<int32_t>(32767));
+      const auto samples1 = chunk1 ? chunk1->sample_count : 0;
+      const auto samples2 = chunk2 ? chunk2->sample_count : 0;
+      const auto *in1 = chunk1 ? chunk1->samples.data() : nullptr;
+      const auto *in2 = chunk2 ? chunk2->samples.data() : nullptr;
+      const auto max_samples = std::max(samples1, samples2);
+      auto &out_chunk = write_queue.producer_slot();
+      auto *out = out_chunk.samples.data();
+
+      // Mix samples in two bounds-check-free ranges: both inputs live on
+      // [0, nmin), then a scaled copy of the longer input on [nmin, nmax).
+      // This replaces the per-sample live-range compares (which also
+      // defeated vectorization) and the zero-fill of the shorter buffer.
+      // All sample-count multiplies happen once per chunk here, so the
+      // kernels below run on precomputed bounds with one induction
+      // variable each.
+      const auto n1 = samples1 * target_channels_;
+      const auto n2 = samples2 * target_channels_;
+      const auto nmin = std::min(n1, n2);
+      const auto nmax = std::max(n1, n2);
+
+      // nmin is 0 once a source has ended, so the long tail of a mix
+      // runs as a pure scaled copy of the surviving input.
+      if (nmin > 0) {
+        mix_s16(in1, in2, out, static_cast<std::size_t>(nmin), vol1_q15_,
+                vol2_q15_);
+      }
+      if (nmax > nmin) {
+        const auto *longer = (n1 > n2) ? in1 : in2;
+        const auto vol_q15 = (n1 > n2) ? vol1_q15_ : vol2_q15_;
+        scale_s16(longer + nmin, out + nmin,
+                  static_cast<std::size_t>(nmax - nmin), vol_q15);
+      }
 
-        output_buffer_[i] = static_cast<int16_t>(mixed);
+      if (chunk1) {
+        queue1.release();
+      }
+      if (chunk2) {
+        queue2.release();
       }
 
-      // Write to file
-      const auto bytes_to_write =
-          max_samples * target_channels_ * sizeof(int16_t);
-      output_stream.write(reinterpret_cast<char *>(output_buffer_.data()),
-                          bytes_to_write);
+      // Hand the mixed chunk to the writer thread
+      out_chunk.sample_count = max_samples;
+      write_queue.publish();
       total_samples_written += max_samples;
 
-      ++iteration;
-      if (iteration % 100 == 0) {
+      // Progress at most every 250 ms of wall time; the format + flush
+      // cost stays out of the hot loop regardless of chunk size.
+      if (const auto now = std::chrono::steady_clock::now();
+          now - last_progress > std::chrono::milliseconds(250)) {
         const auto seconds =
             total_samples_written / static_cast<double>(target_sample_rate_);
         std::cout << std::format("Mixed {:.2f} seconds\r", seconds)
                   << std::flush;
+        last_progress = now;
       }
     }
 
+    worker1.join();
+    worker2.join();
+    write_queue.finish();
+    writer.join();
+
     const auto total_bytes =
         total_samples_written * target_channels_ * sizeof(int16_t);
 
@@ -251,10 +689,15 @@ public:
                                  static_cast<double>(target_sample_rate_));
     std::cout << std::format("Output size: {} bytes\n", total_bytes);
 
-    // Update WAV header
-    output_stream.seekp(0, std::ios::beg);
-    write_wav_header(output_stream, target_sample_rate_, target_channels_,
-                     total_bytes);
+    // Patch the WAV header; the sequential write position is never
+    // moved, and any preallocated slack is trimmed off.
+    const auto header = make_wav_header(target_sample_rate_, target_channels_,
+                                        static_cast<uint32_t>(total_bytes));
+    pwrite(out_fd, &header, sizeof(WAVHeader), 0);
+    ftruncate(out_fd,
+              static_cast<off_t>(sizeof(WAVHeader)) +
+                  static_cast<off_t>(total_bytes));
+    ::close(out_fd);
 
     std::cout << std::format("\nMixing completed successfully!\n");
     std::cout << std::format("Output file: {}\n", output_file_.string());
@@ -263,18 +706,23 @@ public:
 private:
   static constexpr int target_sample_rate_ = 44100;
   static constexpr int target_channels_ = 2;
-  static constexpr int buffer_size_ = 4096;
+  // 32K samples x stereo x 2B = 128 KiB per chunk: big enough that the
+  // decode-loop call overhead (av_read_frame/receive_frame/swr_convert)
+  // and per-chunk write(2) are amortized, while the working set of the
+  // three rings stays L2/L3-resident.
+  static constexpr int buffer_size_ = 32768;
 
   fs::path output_file_;
   float volume1_;
   float volume2_;
+  // Volumes converted to Q15 once at construction; the mix loops are
+  // fully integer and never touch the float members.
+  int16_t vol1_q15_;
+  int16_t vol2_q15_;
 
   AudioDecoder decoder1_;
   AudioDecoder decoder2_;
 
-  std::vector<int16_t> buffer1_;
-  std::vector<int16_t> buffer2_;
-  std::vector<int16_t> output_buffer_;
 };
 
 } // anonymous namespace
@@ -15,16 +15,34 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+extern "C" {
+#include <libavutil/cpu.h>
+}
+
 #include <iostream>
-#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <format>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <new>
 #include <string>
 #include <optional>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -45,9 +63,11 @@ struct WAVHeader {
     uint16_t bits_per_sample;
     char data_header[4] = {'d', 'a', 't', 'a'};
     uint32_t data_bytes;
-};
+} __attribute__((packed));
+
+static_assert(sizeof(WAVHeader) == 44, "WAV header must be written unpadded");
 
-void write_wav_header(std::ofstream& file, int sample_rate, int channels, uint32_t data_size) {
+void write_wav_header(std::FILE* file, int sample_rate, int channels, uint32_t data_size) {
     WAVHeader header;
     header.num_channels = static_cast<uint16_t>(channels);
     header.sample_rate = static_cast<uint32_t>(sample_rate);
@@ -57,9 +77,257 @@ void write_wav_header(std::ofstream& file, int sample_rate, int channels, uint32
     header.data_bytes = data_size;
     header.wav_size = 36 + data_size;
 
-    file.write(reinterpret_cast<const char*>(&header), sizeof(WAVHeader));
+    std::fwrite(&header, sizeof(WAVHeader), 1, file);
+}
+
+// Decoded audio is kept as planar float ([-1, 1]) all the way through
+// the mix; this scale factor maps it to S16 once, in the final
+// conversion pass.
+constexpr float kS16Scale = 32768.0f;
+
+// Minimal 64-byte-aligned allocator so the mix planes and ring slots
+// line up with cache lines; the same pattern as audio_mixer.cpp. Slot
+// contents are always written before being read, so construct() skips
+// the value-initialization memset that resize() would otherwise do.
+template <typename T, std::size_t Alignment>
+struct AlignedAlloc {
+    using value_type = T;
+
+    AlignedAlloc() = default;
+    template <typename U>
+    AlignedAlloc(const AlignedAlloc<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        ::operator delete(p, n * sizeof(T), std::align_val_t{Alignment});
+    }
+
+    template <typename U> void construct(U*) noexcept {}
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U> struct rebind {
+        using other = AlignedAlloc<U, Alignment>;
+    };
+    friend bool operator==(const AlignedAlloc&, const AlignedAlloc&) {
+        return true;
+    }
+};
+
+using PlaneBuffer = std::vector<float, AlignedAlloc<float, 64>>;
+
+// Accumulate one float plane into the mix accumulator with a constant
+// gain, and convert the finished mix planes to interleaved S16. Both
+// kernels exist in per-ISA variants selected once at startup via
+// av_get_cpu_flags(), the way libswresample's convert init picks its
+// asm, so a generic build still uses the wide paths on capable CPUs.
+using accumulate_fn = void (*)(float*, const float*, int, float);
+using convert_fn = void (*)(const float*, const float*, int16_t*, int, float,
+                            float&);
+
+void accumulate_plane_scalar(float* acc, const float* src, int n, float gain) {
+    for (int i = 0; i < n; ++i) {
+        acc[i] += src[i] * gain;
+    }
+}
+
+// Scalar conversion: scale to S16 range, track the pre-gain peak (in
+// S16 units, so the dB prints and auto-gain threshold keep working),
+// apply the auto-gain reduction, clamp and interleave. Folding the gain
+// here removes the second read+write pass over the int16 block the old
+// auto-gain loop did.
+void convert_planes_to_s16_scalar(const float* left, const float* right,
+                                  int16_t* out, int frames, float gain,
+                                  float& max_peak) {
+    for (int i = 0; i < frames; ++i) {
+        const float l = left[i] * kS16Scale;
+        const float r = right[i] * kS16Scale;
+        max_peak = std::max({max_peak, std::fabs(l), std::fabs(r)});
+        out[2 * i] = static_cast<int16_t>(std::clamp(
+            static_cast<int32_t>(std::lrintf(l * gain)), -32768, 32767));
+        out[2 * i + 1] = static_cast<int16_t>(std::clamp(
+            static_cast<int32_t>(std::lrintf(r * gain)), -32768, 32767));
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2,fma"))) void
+accumulate_plane_avx2(float* acc, const float* src, int n, float gain) {
+    int i = 0;
+    const __m256 g = _mm256_set1_ps(gain);
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(acc + i,
+                         _mm256_fmadd_ps(_mm256_loadu_ps(src + i), g,
+                                         _mm256_loadu_ps(acc + i)));
+    }
+    accumulate_plane_scalar(acc + i, src + i, n - i, gain);
+}
+
+// 16 floats per iteration on AVX-512F hosts
+__attribute__((target("avx512f"))) void
+accumulate_plane_avx512(float* acc, const float* src, int n, float gain) {
+    int i = 0;
+    const __m512 g = _mm512_set1_ps(gain);
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(acc + i,
+                         _mm512_fmadd_ps(_mm512_loadu_ps(src + i), g,
+                                         _mm512_loadu_ps(acc + i)));
+    }
+    accumulate_plane_scalar(acc + i, src + i, n - i, gain);
+}
+
+// AVX2 conversion: the hardware pack (packssdw) replaces the per-sample
+// clamp-and-branch the old clamp_add helper did; the peak is a vector
+// max of absolute values reduced once per call instead of a compare per
+// sample.
+__attribute__((target("avx2"))) void
+convert_planes_to_s16_avx2(const float* left, const float* right,
+                           int16_t* out, int frames, float gain,
+                           float& max_peak) {
+    int i = 0;
+    const __m256 scale = _mm256_set1_ps(kS16Scale);
+    const __m256 vgain = _mm256_set1_ps(gain);
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    __m256 vpeak = _mm256_setzero_ps();
+
+    for (; i + 8 <= frames; i += 8) {
+        __m256 l = _mm256_mul_ps(_mm256_loadu_ps(left + i), scale);
+        __m256 r = _mm256_mul_ps(_mm256_loadu_ps(right + i), scale);
+
+        // Peak is tracked pre-gain so the reduction stays stable as the
+        // gain tightens
+        vpeak = _mm256_max_ps(vpeak, _mm256_andnot_ps(sign_mask, l));
+        vpeak = _mm256_max_ps(vpeak, _mm256_andnot_ps(sign_mask, r));
+
+        l = _mm256_mul_ps(l, vgain);
+        r = _mm256_mul_ps(r, vgain);
+
+        // Interleave L/R within lanes, then across lanes, so the stores
+        // come out frame-ordered.
+        const __m256 lo = _mm256_unpacklo_ps(l, r);
+        const __m256 hi = _mm256_unpackhi_ps(l, r);
+        const __m256 ilv0 = _mm256_permute2f128_ps(lo, hi, 0x20);
+        const __m256 ilv1 = _mm256_permute2f128_ps(lo, hi, 0x31);
+
+        // packssdw works per 128-bit lane; permute restores sample order
+        const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(ilv0),
+                                                  _mm256_cvtps_epi32(ilv1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i),
+                            _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+
+    // Single horizontal reduction per block; the loop above never
+    // touches max_peak, so peak tracking costs one vector max per 8
+    // samples instead of a compare-and-store per sample.
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, vpeak);
+    for (const auto v : lanes) {
+        max_peak = std::max(max_peak, v);
+    }
+
+    convert_planes_to_s16_scalar(left + i, right + i, out + 2 * i,
+                                 frames - i, gain, max_peak);
 }
 
+#endif
+
+accumulate_fn select_accumulate_fn() {
+    const int flags = av_get_cpu_flags();
+#if defined(__x86_64__) || defined(__i386__)
+    if (flags & AV_CPU_FLAG_AVX512) {
+        return accumulate_plane_avx512;
+    }
+    if ((flags & AV_CPU_FLAG_AVX2) && (flags & AV_CPU_FLAG_FMA3)) {
+        return accumulate_plane_avx2;
+    }
+#else
+    (void)flags;
+#endif
+    return accumulate_plane_scalar;
+}
+
+convert_fn select_convert_fn() {
+    const int flags = av_get_cpu_flags();
+#if defined(__x86_64__) || defined(__i386__)
+    if (flags & AV_CPU_FLAG_AVX2) {
+        return convert_planes_to_s16_avx2;
+    }
+#else
+    (void)flags;
+#endif
+    return convert_planes_to_s16_scalar;
+}
+
+const accumulate_fn accumulate_plane = select_accumulate_fn();
+const convert_fn convert_planes_to_s16 = select_convert_fn();
+
+// Fixed-depth SPSC ring of decoded float-plane blocks, one per track.
+// A decode thread produces, the mixer thread consumes; the head/tail
+// indices are the only shared state, so acquire/release atomics plus a
+// yield spin are enough.
+class TrackRing {
+public:
+    struct Block {
+        PlaneBuffer planes;  // L plane followed by R plane
+        int sample_count = 0;
+        bool silent = false;  // block is all zeros; planes were not written
+    };
+
+    explicit TrackRing(std::size_t plane_values) {
+        for (auto& slot : slots_) {
+            slot.planes.resize(plane_values);
+        }
+    }
+
+    // Producer: slot to decode into, blocking while the ring is full
+    Block& producer_slot() {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        while ((tail + 1) % kDepth == head_.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        return slots_[tail];
+    }
+
+    void publish() {
+        tail_.store((tail_.load(std::memory_order_relaxed) + 1) % kDepth,
+                    std::memory_order_release);
+    }
+
+    void finish() { done_.store(true, std::memory_order_release); }
+
+    // Consumer: next filled block, or nullptr once the producer finished
+    // and the ring drained
+    Block* acquire() {
+        const auto head = head_.load(std::memory_order_relaxed);
+        while (head == tail_.load(std::memory_order_acquire)) {
+            if (done_.load(std::memory_order_acquire) &&
+                head == tail_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+        return &slots_[head];
+    }
+
+    void release() {
+        head_.store((head_.load(std::memory_order_relaxed) + 1) % kDepth,
+                    std::memory_order_release);
+    }
+
+private:
+    static constexpr std::size_t kDepth = 4;
+    std::array<Block, kDepth> slots_;
+    std::atomic<std::size_t> head_{0};
+    std::atomic<std::size_t> tail_{0};
+    std::atomic<bool> done_{false};
+};
+
 // Track configuration
 struct TrackConfig {
     std::string filename;
@@ -84,10 +352,10 @@ public:
         initialize();
     }
 
-    // Read samples with offset support
-    int read_samples(int16_t* buffer, int num_samples, int64_t current_sample_position) {
-        // Calculate offset in samples
-        const auto offset_samples = static_cast<int64_t>(config_.start_offset * target_sample_rate_);
+    // Read samples with offset support into planar float buffers, one
+    // plane per target channel
+    int read_samples(float* const* planes, int num_samples, int64_t current_sample_position) {
+        const auto offset_samples = offset_samples_;
 
         // If we haven't reached the start offset yet, return silence
         if (current_sample_position < offset_samples) {
@@ -95,7 +363,12 @@ public:
                 num_samples,
                 static_cast<int>(offset_samples - current_sample_position)
             );
-            std::fill_n(buffer, samples_to_skip * target_channels_, int16_t{0});
+            for (int c = 0; c < target_channels_; ++c) {
+                // memset: all-zero bytes are IEEE 0.0f, and the compiler
+                // lowers this to wide stores it won't always emit for a
+                // value fill
+                std::memset(planes[c], 0, samples_to_skip * sizeof(float));
+            }
             return samples_to_skip;
         }
 
@@ -104,18 +377,63 @@ public:
         while (samples_read < num_samples && !eof_) {
             auto ret = avcodec_receive_frame(codec_ctx_.get(), frame_.get());
 
+            if (ret == 0) {
+                // Resample straight into the planes at the current offset
+                uint8_t* out_bufs[2] = {nullptr, nullptr};
+                for (int c = 0; c < target_channels_; ++c) {
+                    out_bufs[c] = reinterpret_cast<uint8_t*>(planes[c] + samples_read);
+                }
+                const auto dst_nb_samples = num_samples - samples_read;
+
+                ret = swr_convert(swr_ctx_.get(), out_bufs, dst_nb_samples,
+                                const_cast<const uint8_t**>(frame_->data), frame_->nb_samples);
+
+                if (ret > 0) {
+                    samples_read += ret;
+                    total_samples_decoded_ += ret;
+                }
+                continue;
+            }
+
             if (ret == AVERROR(EAGAIN)) {
-                // Need more packets
-                ret = av_read_frame(format_ctx_.get(), packet_.get());
-                if (ret < 0) {
-                    eof_ = true;
-                    break;
+                // Feed a small batch of packets per EAGAIN instead of one,
+                // cutting the receive/read round-trips through libav. A
+                // packet the decoder refuses (input queue full) is kept
+                // pending rather than dropped.
+                for (int fed = 0; fed < 4 && !demux_eof_;) {
+                    if (!packet_pending_) {
+                        if (av_read_frame(format_ctx_.get(), packet_.get()) < 0) {
+                            demux_eof_ = true;
+                            // Signal end of stream so buffered frames drain
+                            avcodec_send_packet(codec_ctx_.get(), nullptr);
+                            break;
+                        }
+                        if (packet_->stream_index != stream_index_) {
+                            av_packet_unref(packet_.get());
+                            continue;
+                        }
+                        packet_pending_ = true;
+                    }
+
+                    if (avcodec_send_packet(codec_ctx_.get(), packet_.get()) ==
+                        AVERROR(EAGAIN)) {
+                        break;
+                    }
+                    packet_pending_ = false;
+                    av_packet_unref(packet_.get());
+                    ++fed;
                 }
 
-                if (packet_->stream_index == stream_index_) {
-                    avcodec_send_packet(codec_ctx_.get(), packet_.get());
+                if (demux_eof_ && !packet_pending_) {
+                    // Nothing left to feed; if the decoder still has no
+                    // frame, the next receive returns AVERROR_EOF.
+                    if (avcodec_receive_frame(codec_ctx_.get(), frame_.get()) ==
+                        AVERROR_EOF) {
+                        eof_ = true;
+                        break;
+                    }
+                    av_frame_unref(frame_.get());
                 }
-                av_packet_unref(packet_.get());
                 continue;
             }
 
@@ -123,18 +441,6 @@ public:
                 eof_ = true;
                 break;
             }
-
-            // Resample
-            auto* out_buf = reinterpret_cast<uint8_t*>(buffer + samples_read * target_channels_);
-            const auto dst_nb_samples = num_samples - samples_read;
-
-            ret = swr_convert(swr_ctx_.get(), &out_buf, dst_nb_samples,
-                            const_cast<const uint8_t**>(frame_->data), frame_->nb_samples);
-
-            if (ret > 0) {
-                samples_read += ret;
-                total_samples_decoded_ += ret;
-            }
         }
 
         return samples_read;
@@ -152,8 +458,32 @@ public:
     const TrackConfig& get_config() const { return config_; }
     int64_t get_total_samples_decoded() const { return total_samples_decoded_; }
 
+    // Volume folded with the equal-power pan gains, computed once at
+    // construction so mix_track never re-runs the sin/cos setup
+    float vol_left() const { return vol_left_; }
+    float vol_right() const { return vol_right_; }
+
+    // Track start in output samples, for skipping blocks that end before it
+    int64_t offset_samples() const { return offset_samples_; }
+
+    // Container-duration estimate in output samples; anchors the fade-out
+    // ramp (the exact decoded count is only known after EOF)
+    int64_t duration_samples() const {
+        return static_cast<int64_t>(get_duration() * target_sample_rate_);
+    }
+
 private:
     void initialize() {
+        // Equal-power pan gains (-1..1 -> 0..π/2), folded with volume.
+        // One sin/cos pair per track for its whole lifetime; a pan LUT or
+        // polynomial law only pays off if per-sample pan automation is
+        // ever added.
+        const float pan_angle = (config_.pan + 1.0f) * 0.25f * M_PI;
+        vol_left_ = config_.volume * std::cos(pan_angle);
+        vol_right_ = config_.volume * std::sin(pan_angle);
+
+        offset_samples_ = static_cast<int64_t>(config_.start_offset * target_sample_rate_);
+
         // Find audio stream
         const auto stream_idx = ffmpeg::find_stream_index(format_ctx_.get(), AVMEDIA_TYPE_AUDIO);
         if (!stream_idx) {
@@ -178,7 +508,11 @@ private:
             "open decoder"
         );
 
-        // Setup resampler
+        // Setup resampler. Planar float output keeps swr on its float
+        // SIMD kernels end to end: decoded int formats take the
+        // int->float fast path and no int16 requantize (and therefore no
+        // dither stage) ever runs inside swr -- the one float->S16
+        // conversion happens in our own fused pass after mixing.
         AVChannelLayout out_ch_layout;
         if (target_channels_ == 1) {
             out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
@@ -189,7 +523,7 @@ private:
         ffmpeg::check_error(
             swr_alloc_set_opts2(&swr_ctx_raw_,
                               &out_ch_layout,
-                              AV_SAMPLE_FMT_S16,
+                              AV_SAMPLE_FMT_FLTP,
                               target_sample_rate_,
                               &codec_ctx_->ch_layout,
                               codec_ctx_->sample_fmt,
@@ -216,9 +550,14 @@ private:
     SwrContext* swr_ctx_raw_ = nullptr;
     int stream_index_ = -1;
     bool eof_ = false;
+    bool demux_eof_ = false;
+    bool packet_pending_ = false;
+    int64_t offset_samples_ = 0;
     int target_sample_rate_;
     int target_channels_;
     int64_t total_samples_decoded_ = 0;
+    float vol_left_ = 1.0f;
+    float vol_right_ = 1.0f;
 };
 
 // Advanced audio mixer with multi-track support
@@ -244,14 +583,20 @@ public:
     void mix() {
         print_mixing_info();
 
-        // Open output file
-        std::ofstream output_stream(output_file_, std::ios::binary);
-        if (!output_stream.is_open()) {
+        // Open the output through stdio with a 1 MiB buffer: block writes
+        // coalesce in userspace instead of taking the iostream path with
+        // its locking and virtual dispatch per write
+        std::FILE* output_file = std::fopen(output_file_.c_str(), "wb");
+        if (!output_file) {
             throw std::runtime_error(std::format("Failed to open output file: {}", output_file_.string()));
         }
+        // 1 MiB stdio buffer: fwrite coalesces the per-block stores so
+        // the kernel sees one write(2) per megabyte instead of one per
+        // 16 KiB block; no hand-rolled staging buffer or writev needed
+        std::setvbuf(output_file, nullptr, _IOFBF, 1 << 20);
 
         // Write placeholder WAV header
-        write_wav_header(output_stream, target_sample_rate_, target_channels_, 0);
+        write_wav_header(output_file, target_sample_rate_, target_channels_, 0);
 
         // Calculate total duration (max of all tracks including offsets)
         double max_duration = 0.0;
@@ -260,84 +605,169 @@ public:
             max_duration = std::max(max_duration, track_end);
         }
 
+        // Reserve the estimated size upfront so the file doesn't grow one
+        // block at a time (extent churn on large mixes); slack is trimmed
+        // after the final header rewrite
+        if (max_duration > 0.0) {
+            const auto expected_bytes =
+                static_cast<off_t>(sizeof(WAVHeader)) +
+                static_cast<off_t>(max_duration * target_sample_rate_) *
+                    target_channels_ * static_cast<off_t>(sizeof(int16_t));
+            posix_fallocate(fileno(output_file), 0, expected_bytes); // best effort
+        }
+
         std::cout << std::format("Estimated total duration: {:.2f} seconds\n\n", max_duration);
         std::cout << "Mixing in progress...\n";
 
-        // Allocate buffers for each track
-        std::vector<std::vector<int16_t>> track_buffers(decoders_.size());
-        for (auto& buffer : track_buffers) {
-            buffer.resize(buffer_size_ * target_channels_);
+        // Planar float working set: the mix accumulators plus, per track,
+        // an SPSC ring of decoded blocks fed by its own thread. Decoder
+        // contexts are independent, so all N tracks decode in parallel
+        // with each other and with the mix/convert/write below.
+        std::vector<std::unique_ptr<TrackRing>> rings;
+        rings.reserve(decoders_.size());
+        for (size_t track_idx = 0; track_idx < decoders_.size(); ++track_idx) {
+            rings.push_back(std::make_unique<TrackRing>(
+                static_cast<std::size_t>(buffer_size_) * target_channels_));
         }
 
-        std::vector<int16_t> mix_buffer(buffer_size_ * target_channels_);
+        std::vector<std::thread> producers;
+        producers.reserve(decoders_.size());
+        for (size_t track_idx = 0; track_idx < decoders_.size(); ++track_idx) {
+            producers.emplace_back([this, &rings, track_idx] {
+                auto& decoder = *decoders_[track_idx];
+                auto& ring = *rings[track_idx];
+                int64_t position = 0;
+                while (!decoder.is_eof()) {
+                    auto& slot = ring.producer_slot();
+
+                    // Blocks entirely before the track's start offset are
+                    // published as silent markers: no zero-fill of the
+                    // planes, no decode, and the mixer skips them outright
+                    if (position + buffer_size_ <= decoder.offset_samples()) {
+                        slot.sample_count = buffer_size_;
+                        slot.silent = true;
+                        ring.publish();
+                        position += buffer_size_;
+                        continue;
+                    }
+
+                    float* plane_ptrs[2] = {slot.planes.data(),
+                                            slot.planes.data() + buffer_size_};
+                    const auto n = decoder.read_samples(plane_ptrs, buffer_size_, position);
+                    if (n <= 0) {
+                        break;
+                    }
+                    slot.sample_count = n;
+                    slot.silent = false;
+                    ring.publish();
+                    // The mixer advances one full block per iteration, so
+                    // the producer's clock does too even on short reads
+                    position += buffer_size_;
+                }
+                ring.finish();
+            });
+        }
+
+        PlaneBuffer mix_left(buffer_size_);
+        PlaneBuffer mix_right(target_channels_ == 2 ? buffer_size_ : 0);
+        std::vector<int16_t, AlignedAlloc<int16_t, 64>> out_buffer(
+            buffer_size_ * target_channels_);
         int64_t current_sample_position = 0;
         uint32_t total_samples_written = 0;
-        int iteration = 0;
         float max_peak = 0.0f;
+        auto last_progress = std::chrono::steady_clock::now();
 
         // Mixing loop
         bool any_active = true;
         while (any_active) {
             any_active = false;
 
-            // Clear mix buffer
-            std::fill(mix_buffer.begin(), mix_buffer.end(), int16_t{0});
+            // Clear mix accumulators; memset stays a wide-store clear
+            // even in unoptimized builds, where std::fill is a scalar
+            // loop
+            std::memset(mix_left.data(), 0, mix_left.size() * sizeof(float));
+            std::memset(mix_right.data(), 0, mix_right.size() * sizeof(float));
 
-            // Read and mix all tracks
+            // Consume one decoded block per track and mix it
             for (size_t track_idx = 0; track_idx < decoders_.size(); ++track_idx) {
                 auto& decoder = decoders_[track_idx];
-                auto& buffer = track_buffers[track_idx];
+                auto* block = rings[track_idx]->acquire();
 
-                if (decoder->is_eof()) {
+                if (!block) {
                     continue;
                 }
+                any_active = true;
 
-                const auto samples_read = decoder->read_samples(
-                    buffer.data(),
-                    buffer_size_,
-                    current_sample_position
-                );
+                if (block->silent) {
+                    // Zero contribution; keeps the track's clock advancing
+                    rings[track_idx]->release();
+                    continue;
+                }
 
-                if (samples_read > 0) {
-                    any_active = true;
-                    const auto& config = decoder->get_config();
+                // Apply effects and mix
+                mix_track(mix_left.data(), mix_right.data(),
+                          block->planes.data(),
+                          block->planes.data() + buffer_size_,
+                          block->sample_count, decoder->get_config(),
+                          current_sample_position,
+                          decoder->vol_left(), decoder->vol_right(),
+                          decoder->duration_samples());
 
-                    // Apply effects and mix
-                    mix_track(mix_buffer, buffer, samples_read, config,
-                             current_sample_position, max_peak);
-                }
+                rings[track_idx]->release();
             }
 
             if (!any_active) {
                 break;
             }
 
-            // Apply auto-gain if enabled
-            if (auto_gain_ && max_peak > 0.0f) {
-                const auto gain_reduction = std::min(1.0f, 32767.0f / max_peak);
-                if (gain_reduction < 1.0f) {
-                    for (auto& sample : mix_buffer) {
-                        sample = static_cast<int16_t>(sample * gain_reduction);
-                    }
+            // Single float->int16 conversion pass: yields the peak and
+            // applies auto-gain in the same sweep. The gain follows the
+            // running peak with one block of latency (the current block's
+            // peak lands during its own conversion); the saturating pack
+            // covers that transient, and the old two-pass version traded
+            // a full extra read+write over the block for the same abrupt
+            // per-block gain steps.
+            const float gain = (auto_gain_ && max_peak > 32767.0f)
+                                   ? 32767.0f / max_peak
+                                   : 1.0f;
+            if (target_channels_ == 2) {
+                convert_planes_to_s16(mix_left.data(), mix_right.data(),
+                                      out_buffer.data(), buffer_size_, gain,
+                                      max_peak);
+            } else {
+                for (int i = 0; i < buffer_size_; ++i) {
+                    const float v = mix_left[i] * kS16Scale;
+                    max_peak = std::max(max_peak, std::fabs(v));
+                    out_buffer[i] = static_cast<int16_t>(std::clamp(
+                        static_cast<int32_t>(std::lrintf(v * gain)), -32768, 32767));
                 }
             }
 
             // Write to file
             const auto bytes_to_write = buffer_size_ * target_channels_ * sizeof(int16_t);
-            output_stream.write(reinterpret_cast<char*>(mix_buffer.data()), bytes_to_write);
+            std::fwrite(out_buffer.data(), 1, bytes_to_write, output_file);
             total_samples_written += buffer_size_;
             current_sample_position += buffer_size_;
 
-            ++iteration;
-            if (iteration % 100 == 0) {
+            // Progress at most every 250 ms of wall time, as one formatted
+            // write; log2 has the faster libm path and 20*log10(x) is just
+            // 20*log10(2)*log2(x)
+            if (const auto now = std::chrono::steady_clock::now();
+                now - last_progress > std::chrono::milliseconds(250)) {
+                constexpr float kDbPerLog2 = 20.0f * 0.3010299957f;
                 const auto seconds = total_samples_written / static_cast<double>(target_sample_rate_);
                 std::cout << std::format("Mixed {:.2f} seconds (peak: {:.2f} dB)\r",
                                         seconds,
-                                        20.0f * std::log10(max_peak / 32768.0f))
+                                        kDbPerLog2 * std::log2(max_peak / 32768.0f))
                          << std::flush;
+                last_progress = now;
             }
         }
 
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
         const auto total_bytes = total_samples_written * target_channels_ * sizeof(int16_t);
 
         std::cout << std::format("\n\nMixing completed!\n");
@@ -348,87 +778,112 @@ public:
                                 20.0f * std::log10(max_peak / 32768.0f));
         std::cout << std::format("Output size: {} bytes\n", total_bytes);
 
-        // Update WAV header
-        output_stream.seekp(0, std::ios::beg);
-        write_wav_header(output_stream, target_sample_rate_, target_channels_, total_bytes);
+        // Update WAV header and trim any preallocated slack
+        std::fseek(output_file, 0, SEEK_SET);
+        write_wav_header(output_file, target_sample_rate_, target_channels_, total_bytes);
+        std::fflush(output_file);
+        ftruncate(fileno(output_file),
+                  static_cast<off_t>(sizeof(WAVHeader)) + static_cast<off_t>(total_bytes));
+        std::fclose(output_file);
 
         std::cout << std::format("\nOutput file: {}\n", output_file_.string());
     }
 
 private:
-    void mix_track(std::vector<int16_t>& mix_buffer,
-                   const std::vector<int16_t>& track_buffer,
+    void mix_track(float* mix_left, float* mix_right,
+                   const float* src_left, const float* src_right,
                    int samples_read,
                    const TrackConfig& config,
                    int64_t current_position,
-                   float& max_peak) {
+                   float vol_left, float vol_right,
+                   int64_t track_duration_samples) {
 
         const auto offset_samples = static_cast<int64_t>(config.start_offset * target_sample_rate_);
         const auto fade_in_samples = static_cast<int64_t>(config.fade_in * target_sample_rate_);
         const auto fade_out_samples = static_cast<int64_t>(config.fade_out * target_sample_rate_);
 
-        // Calculate pan gains (equal power panning)
-        const float pan_angle = (config.pan + 1.0f) * 0.25f * M_PI; // -1..1 -> 0..π/2
-        const float left_gain = std::cos(pan_angle);
-        const float right_gain = std::sin(pan_angle);
-
-        for (int i = 0; i < samples_read; ++i) {
-            const auto sample_pos = current_position + i;
-
-            // Calculate fade envelope
-            float envelope = 1.0f;
+        // Block entirely before the track start: read_samples already
+        // returned silence, nothing to accumulate.
+        if (current_position + samples_read <= offset_samples) {
+            return;
+        }
 
-            // Fade in
-            if (sample_pos < offset_samples + fade_in_samples) {
-                const auto fade_pos = sample_pos - offset_samples;
-                if (fade_pos >= 0) {
-                    envelope *= static_cast<float>(fade_pos) / fade_in_samples;
-                }
-            }
+        // Split the block at the end of the fade-in ramp: past it every
+        // sample sees the same gain, so the bulk of the mix runs in the
+        // plane-accumulate kernel. Only the ramp itself (bounded by the
+        // fade-in length across the whole mix) stays scalar.
+        const auto fade_end = offset_samples + fade_in_samples;
+        int ramp_samples = 0;
+        if (current_position < fade_end) {
+            ramp_samples = static_cast<int>(
+                std::min<int64_t>(samples_read, fade_end - current_position));
+        }
 
-            // Fade out (simplified - would need to know track end position)
-            if (fade_out_samples > 0) {
-                // This is a placeholder - real implementation would track track end
-                // envelope *= fade_out_factor;
-            }
+        // The ramp envelope is a running increment of 1/fade_in per frame
+        // rather than a divide and two window compares per sample; frames
+        // still before the track start clamp to 0.
+        const float inv_fade_in =
+            fade_in_samples > 0 ? 1.0f / static_cast<float>(fade_in_samples) : 0.0f;
+        float env_acc =
+            static_cast<float>(current_position - offset_samples) * inv_fade_in;
 
-            // Apply volume, pan, and envelope
-            const auto left_idx = i * target_channels_;
-            const auto right_idx = left_idx + 1;
+        for (int i = 0; i < ramp_samples; ++i, env_acc += inv_fade_in) {
+            const float envelope = std::clamp(env_acc, 0.0f, 1.0f);
 
             if (target_channels_ == 2) {
-                const auto left_sample = track_buffer[left_idx];
-                const auto right_sample = track_buffer[right_idx];
-
-                const auto mixed_left = static_cast<int32_t>(
-                    left_sample * config.volume * left_gain * envelope
-                );
-                const auto mixed_right = static_cast<int32_t>(
-                    right_sample * config.volume * right_gain * envelope
-                );
-
-                mix_buffer[left_idx] = clamp_add(mix_buffer[left_idx], mixed_left, max_peak);
-                mix_buffer[right_idx] = clamp_add(mix_buffer[right_idx], mixed_right, max_peak);
+                mix_left[i] += src_left[i] * vol_left * envelope;
+                mix_right[i] += src_right[i] * vol_right * envelope;
             } else {
                 // Mono
-                const auto sample = track_buffer[left_idx];
-                const auto mixed = static_cast<int32_t>(sample * config.volume * envelope);
-                mix_buffer[left_idx] = clamp_add(mix_buffer[left_idx], mixed, max_peak);
+                mix_left[i] += src_left[i] * config.volume * envelope;
             }
         }
-    }
 
-    static int16_t clamp_add(int16_t current, int32_t add_value, float& max_peak) {
-        const auto result = static_cast<int32_t>(current) + add_value;
-        const auto abs_result = std::abs(result);
-
-        if (abs_result > max_peak) {
-            max_peak = static_cast<float>(abs_result);
+        // Fade-out ramp, anchored to the container-duration estimate.
+        // Like the fade-in, the split is computed once per block so the
+        // region between the two ramps never tests a fade condition.
+        int tail_samples = 0;
+        if (fade_out_samples > 0 && track_duration_samples > 0) {
+            const auto track_end = offset_samples + track_duration_samples;
+            const auto fade_out_start = track_end - fade_out_samples;
+            if (current_position + samples_read > fade_out_start) {
+                tail_samples = static_cast<int>(std::min<int64_t>(
+                    samples_read - ramp_samples,
+                    current_position + samples_read - fade_out_start));
+                tail_samples = std::max(tail_samples, 0);
+
+                const auto tail_begin = samples_read - tail_samples;
+                const float inv_fade_out =
+                    1.0f / static_cast<float>(fade_out_samples);
+                float env_out =
+                    static_cast<float>(track_end -
+                                       (current_position + tail_begin)) *
+                    inv_fade_out;
+                for (int i = tail_begin; i < samples_read;
+                     ++i, env_out -= inv_fade_out) {
+                    const float envelope = std::clamp(env_out, 0.0f, 1.0f);
+                    if (target_channels_ == 2) {
+                        mix_left[i] += src_left[i] * vol_left * envelope;
+                        mix_right[i] += src_right[i] * vol_right * envelope;
+                    } else {
+                        mix_left[i] += src_left[i] * config.volume * envelope;
+                    }
+                }
+            }
         }
 
-        return static_cast<int16_t>(
-            std::clamp(result, static_cast<int32_t>(-32768), static_cast<int32_t>(32767))
-        );
+        // Constant-gain region between the ramps. With planar
+        // accumulation there is no interleaved [L,R,L,R,...] gain vector
+        // to rebuild per call: each plane's kernel broadcasts its single
+        // precomputed gain once, so this path is just a load/fmadd/store
+        // per vector of frames.
+        const auto n = samples_read - ramp_samples - tail_samples;
+        if (target_channels_ == 2) {
+            accumulate_plane(mix_left + ramp_samples, src_left + ramp_samples, n, vol_left);
+            accumulate_plane(mix_right + ramp_samples, src_right + ramp_samples, n, vol_right);
+        } else {
+            accumulate_plane(mix_left + ramp_samples, src_left + ramp_samples, n, config.volume);
+        }
     }
 
     void print_mixing_info() const {
@@ -7,12 +7,23 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <format>
-#include <fstream>
 #include <iostream>
 #include <string_view>
-#include <unordered_map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -33,10 +44,11 @@ struct WAVHeader {
   uint16_t bits_per_sample;
   char data_header[4] = {'d', 'a', 't', 'a'};
   uint32_t data_bytes;
-};
+} __attribute__((packed));
+
+static_assert(sizeof(WAVHeader) == 44, "WAV header must be written unpadded");
 
-void write_wav_header(std::ofstream &file, int sample_rate, int channels,
-                      uint32_t data_size) {
+WAVHeader make_wav_header(int sample_rate, int channels, uint32_t data_size) {
   WAVHeader header;
   header.num_channels = static_cast<uint16_t>(channels);
   header.sample_rate = static_cast<uint32_t>(sample_rate);
@@ -45,43 +57,112 @@ void write_wav_header(std::ofstream &file, int sample_rate, int channels,
   header.block_align = static_cast<uint16_t>(channels * 2);
   header.data_bytes = data_size;
   header.wav_size = 36 + data_size;
-
-  file.write(reinterpret_cast<const char *>(&header), sizeof(WAVHeader));
+  return header;
 }
 
+// Nine fixed presets: a constexpr table in rodata plus a linear scan
+// beats an unordered_map here -- no heap, no hashing, no once-per-process
+// init guard for a lookup that runs exactly once per invocation. A
+// generated perfect hash would save a handful of compares on that one
+// lookup; not worth carrying generated code in the tree.
+constexpr std::array<std::pair<std::string_view, std::string_view>, 9>
+    kFilterPresets{
+        {{"light",
+          "highpass=f=80,lowpass=f=15000,anlmdn=s=1:p=0.002:r=0.002:m=15"},
+         {"medium",
+          "highpass=f=100,lowpass=f=12000,anlmdn=s=3:p=0.004:r=0.004:m="
+          "15,volume=1.5"},
+         {"heavy",
+          "highpass=f=150,lowpass=f=10000,anlmdn=s=5:p=0.006:r=0.006:m="
+          "15,volume=2.0"},
+         {"voice",
+          "highpass=f=80,lowpass=f=8000,anlmdn=s=2:p=0.003:r=0.003:m=15,"
+          "loudnorm=I=-16:TP=-1.5:LRA=11"},
+         {"music",
+          "highpass=f=20,lowpass=f=18000,anlmdn=s=1:p=0.001:r=0.001:m=15"},
+         {"podcast",
+          "highpass=f=100,lowpass=f=10000,anlmdn=s=2:p=0.003:r=0.003:"
+          "m=15,loudnorm=I=-19:TP=-2:LRA=15,compand=attacks=0.3:"
+          "decays=0.8:points=-70/-70|-60/-20|-20/-10|0/-5|20/0"},
+         {"denoise_only", "anlmdn=s=3:p=0.004:r=0.004:m=15"},
+         {"normalize", "loudnorm=I=-16:TP=-1.5:LRA=11"},
+         {"compress",
+          "compand=attacks=0.3:decays=0.8:points=-80/-80|-45/-15|-27/"
+          "-9|-5/-4|0/-1|20/0"}}};
+
 std::string_view get_filter_description(std::string_view preset) {
-  static const std::unordered_map<std::string_view, std::string_view> presets =
-      {{"light",
-        "highpass=f=80,lowpass=f=15000,anlmdn=s=1:p=0.002:r=0.002:m=15"},
-       {"medium", "highpass=f=100,lowpass=f=12000,anlmdn=s=3:p=0.004:r=0.004:m="
-                  "15,volume=1.5"},
-       {"heavy", "highpass=f=150,lowpass=f=10000,anlmdn=s=5:p=0.006:r=0.006:m="
-                 "15,volume=2.0"},
-       {"voice", "highpass=f=80,lowpass=f=8000,anlmdn=s=2:p=0.003:r=0.003:m=15,"
-                 "loudnorm=I=-16:TP=-1.5:LRA=11"},
-       {"music",
-        "highpass=f=20,lowpass=f=18000,anlmdn=s=1:p=0.001:r=0.001:m=15"},
-       {"podcast", "highpass=f=100,lowpass=f=10000,anlmdn=s=2:p=0.003:r=0.003:"
-                   "m=15,loudnorm=I=-19:TP=-2:LRA=15,compand=attacks=0.3:"
-                   "decays=0.8:points=-70/-70|-60/-20|-20/-10|0/-5|20/0"},
-       {"denoise_only", "anlmdn=s=3:p=0.004:r=0.004:m=15"},
-       {"normalize", "loudnorm=I=-16:TP=-1.5:LRA=11"},
-       {"compress", "compand=attacks=0.3:decays=0.8:points=-80/-80|-45/-15|-27/"
-                    "-9|-5/-4|0/-1|20/0"}};
-
-  const auto it = presets.find(preset);
-  return it != presets.end() ? it->second : "";
+  for (const auto &[name, description] : kFilterPresets) {
+    if (name == preset) {
+      return description;
+    }
+  }
+  return "";
 }
 
+// Bounded SPSC ring of preallocated AVFrames connecting two pipeline
+// stages. Frame ownership moves through the ring with av_frame_move_ref,
+// so steady state does no per-frame allocation and no clone. Same
+// single-producer/single-consumer discipline as the mixer rings: the
+// head/tail indices are the only shared state.
+class FrameRing {
+public:
+  FrameRing() {
+    for (auto &slot : slots_) {
+      slot = ffmpeg::create_frame();
+    }
+  }
+
+  // Producer: frame to fill next, blocking while the ring is full
+  AVFrame *producer_slot() {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    while ((tail + 1) % kDepth == head_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    return slots_[tail].get();
+  }
+
+  void publish() {
+    tail_.store((tail_.load(std::memory_order_relaxed) + 1) % kDepth,
+                std::memory_order_release);
+  }
+
+  void finish() { done_.store(true, std::memory_order_release); }
+
+  // Consumer: next frame, or nullptr once the producer finished and the
+  // ring drained. Callers unref the frame before release().
+  AVFrame *acquire() {
+    const auto head = head_.load(std::memory_order_relaxed);
+    while (head == tail_.load(std::memory_order_acquire)) {
+      if (done_.load(std::memory_order_acquire) &&
+          head == tail_.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      std::this_thread::yield();
+    }
+    return slots_[head].get();
+  }
+
+  void release() {
+    head_.store((head_.load(std::memory_order_relaxed) + 1) % kDepth,
+                std::memory_order_release);
+  }
+
+private:
+  static constexpr std::size_t kDepth = 8;
+  std::array<ffmpeg::FramePtr, kDepth> slots_;
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<bool> done_{false};
+};
+
 class AudioNoiseReducer {
 public:
   AudioNoiseReducer(std::string_view input_file, const fs::path &output_file,
                     std::string_view filter_preset)
-      : output_file_(output_file),
+      : output_file_(output_file), preset_(filter_preset),
         filter_description_(get_filter_description(filter_preset)),
         format_ctx_(ffmpeg::open_input_format(input_file.data())),
-        packet_(ffmpeg::create_packet()), frame_(ffmpeg::create_frame()),
-        filtered_frame_(ffmpeg::create_frame()) {
+        packet_(ffmpeg::create_packet()), frame_(ffmpeg::create_frame()) {
 
     if (filter_description_.empty()) {
       throw std::invalid_argument(
@@ -105,90 +186,224 @@ public:
     std::cout << std::format("Channels: {}\n\n",
                              codec_ctx_->ch_layout.nb_channels);
 
-    // Open output file
-    std::ofstream output_stream(output_file_, std::ios::binary);
-    if (!output_stream.is_open()) {
+    // Raw fd output: ofstream adds sentry/locale plumbing per write that
+    // a binary PCM stream never needs, and the final header fix-up can
+    // use pwrite(2) instead of seeking the active stream. Frames are
+    // staged into a 1 MiB buffer so the kernel still sees megabyte-sized
+    // writes, matching the old stream buffering.
+    const int out_fd =
+        ::open(output_file_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
       throw std::runtime_error(
           std::format("Failed to open output file: {}", output_file_.string()));
     }
 
     // Write placeholder WAV header
-    write_wav_header(output_stream, out_sample_rate_, out_channels_, 0);
+    auto header = make_wav_header(out_sample_rate_, out_channels_, 0);
+    ::write(out_fd, &header, sizeof(WAVHeader));
+
+    // When the container reports a duration, pre-size the file and map
+    // it: frame writes become plain memcpys into the page cache and the
+    // kernel schedules write-back itself, so the write stage never
+    // blocks on a syscall. Unknown durations (and an overrun estimate)
+    // fall back to the staged write(2) path below.
+    std::size_t mapped_size = 0;
+    char *mapped = nullptr;
+    if (format_ctx_->duration > 0) {
+      const auto est_seconds =
+          format_ctx_->duration / static_cast<double>(AV_TIME_BASE);
+      const auto est =
+          sizeof(WAVHeader) +
+          static_cast<std::size_t>(est_seconds * out_sample_rate_ *
+                                   out_channels_ * sizeof(int16_t) * 1.1);
+      if (ftruncate(out_fd, static_cast<off_t>(est)) == 0) {
+        void *m = mmap(nullptr, est, PROT_WRITE, MAP_SHARED, out_fd, 0);
+        if (m != MAP_FAILED) {
+          mapped = static_cast<char *>(m);
+          mapped_size = est;
+        }
+      }
+    }
+    std::size_t write_off = sizeof(WAVHeader);
+
+    // Fallback coalescing buffer: frames are often under 2 KiB, so the
+    // non-mmap path batches them here and issues one write(2) per MiB
+    std::vector<char> stage(1 << 20);
+    std::size_t stage_pos = 0;
+    const auto flush_stage = [&] {
+      if (stage_pos > 0) {
+        ::write(out_fd, stage.data(), stage_pos);
+        stage_pos = 0;
+      }
+    };
 
     uint32_t total_data_size = 0;
     int frame_count = 0;
 
     std::cout << "Processing audio...\n";
 
-    // Process all frames
-    while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(packet_.get());
+    // Three-stage pipeline: demux+decode, filter, resample+write. The
+    // denoise filters (anlmdn in most presets) dominate the CPU cost, so
+    // running them on their own thread overlaps filtering with decode
+    // and with file I/O instead of serializing all three.
+    FrameRing decoded_ring;
+    FrameRing filtered_ring;
 
-      if (packet_->stream_index != audio_stream_index_) {
-        continue;
-      }
-
-      const auto ret = avcodec_send_packet(codec_ctx_.get(), packet_.get());
-      if (ret < 0) {
-        continue;
-      }
+    std::thread decode_thread([this, &decoded_ring] {
+      const auto drain_decoder = [this, &decoded_ring] {
+        while (true) {
+          const auto recv_ret =
+              avcodec_receive_frame(codec_ctx_.get(), frame_.get());
+          // Exit branches marked cold so the fallthrough is the decoded-
+          // frame path; the drain sees EAGAIN once per packet batch
+          if (recv_ret == AVERROR(EAGAIN) || recv_ret == AVERROR_EOF)
+              [[unlikely]] {
+            break;
+          }
+          if (recv_ret < 0) [[unlikely]] {
+            std::cerr << "Error during decoding\n";
+            break;
+          }
+          // move_ref hands the buffer refs to the ring slot and resets
+          // frame_, so no unref (and no atomic decrement) happens on
+          // this side; the only unrefs left per frame are the two that
+          // ownership genuinely requires.
+          av_frame_move_ref(decoded_ring.producer_slot(), frame_.get());
+          decoded_ring.publish();
+        }
+      };
 
-      while (true) {
-        const auto recv_ret =
-            avcodec_receive_frame(codec_ctx_.get(), frame_.get());
+      while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
+        ffmpeg::ScopedPacketUnref packet_guard(packet_.get());
 
-        if (recv_ret == AVERROR(EAGAIN) || recv_ret == AVERROR_EOF) {
-          break;
+        // Start pulling the packet payload toward the cache while the
+        // stream check and send bookkeeping run
+        if (packet_->data != nullptr) {
+          __builtin_prefetch(packet_->data);
+          __builtin_prefetch(packet_->data + 64);
         }
 
-        if (recv_ret < 0) {
-          std::cerr << "Error during decoding\n";
-          break;
+        if (packet_->stream_index != audio_stream_index_) {
+          continue;
         }
+        if (avcodec_send_packet(codec_ctx_.get(), packet_.get()) < 0) {
+          continue;
+        }
+        drain_decoder();
+      }
 
-        ffmpeg::ScopedFrameUnref frame_guard(frame_.get());
-
-        // Push frame to filter graph
-        ffmpeg::check_error(
-            av_buffersrc_add_frame_flags(buffersrc_ctx_, frame_.get(),
-                                         AV_BUFFERSRC_FLAG_KEEP_REF),
-            "feed frame to filter graph");
+      // Flush frames buffered inside the decoder
+      avcodec_send_packet(codec_ctx_.get(), nullptr);
+      drain_decoder();
+      decoded_ring.finish();
+    });
 
-        // Pull filtered frames
+    std::thread filter_thread([this, &decoded_ring, &filtered_ring] {
+      const auto pull_filtered = [this, &filtered_ring] {
         while (true) {
-          const auto filter_ret =
-              av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get());
-
-          if (filter_ret == AVERROR(EAGAIN) || filter_ret == AVERROR_EOF) {
+          AVFrame *out = filtered_ring.producer_slot();
+          const auto filter_ret = av_buffersink_get_frame(buffersink_ctx_, out);
+          if (filter_ret == AVERROR(EAGAIN) || filter_ret == AVERROR_EOF)
+              [[unlikely]] {
             break;
           }
-
-          if (filter_ret < 0) {
+          if (filter_ret < 0) [[unlikely]] {
             std::cerr << "Error getting filtered frame\n";
             break;
           }
+          filtered_ring.publish();
+        }
+      };
 
-          ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
+      while (AVFrame *decoded = decoded_ring.acquire()) {
+        // No KEEP_REF: the graph takes the frame's references and resets
+        // it, so the slot goes back into the ring clean with no clone
+        if (av_buffersrc_add_frame_flags(buffersrc_ctx_, decoded, 0) < 0) {
+          std::cerr << "Error feeding filter graph\n";
+        }
+        decoded_ring.release();
+        pull_filtered();
+      }
 
-          // Write filtered audio
-          total_data_size += write_frame(output_stream);
-          ++frame_count;
+      // Signal EOF to the graph and drain what the filters buffered
+      av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0);
+      pull_filtered();
+      filtered_ring.finish();
+    });
+
+    // Progress reporting lives on its own thread: the write stage just
+    // bumps an atomic counter and the logger samples it at 10 Hz, so no
+    // formatting, clock read, or terminal write happens on the hot path
+    std::atomic<int> processed{0};
+    std::atomic<bool> logging{true};
+    std::thread logger([&processed, &logging] {
+      while (logging.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::cout << std::format("Processed {} frames\r",
+                                 processed.load(std::memory_order_relaxed))
+                  << std::flush;
+      }
+    });
+
+    // This thread is the third stage: land the S16 payload in the file
+    while (AVFrame *filtered = filtered_ring.acquire()) {
+      // Direct multiply rather than av_samples_get_buffer_size: the sink
+      // constraint pins the format to packed S16, so the payload size is
+      // exactly samples * channels * 2 with no per-frame PLT call
+      const auto bytes = static_cast<std::size_t>(filtered->nb_samples) *
+                         filtered->ch_layout.nb_channels * sizeof(int16_t);
+
+      if (mapped && write_off + bytes > mapped_size) {
+        // Estimate ran out; continue with staged writes from here
+        munmap(mapped, mapped_size);
+        mapped = nullptr;
+        lseek(out_fd, static_cast<off_t>(write_off), SEEK_SET);
+      }
 
-          if (frame_count % 100 == 0) {
-            std::cout << std::format("Processed {} frames\r", frame_count)
-                      << std::flush;
-          }
+      if (mapped) {
+        std::memcpy(mapped + write_off, filtered->data[0], bytes);
+      } else if (bytes > stage.size()) {
+        // Oversized frames bypass the stage rather than growing it; the
+        // stage stays a single fixed allocation for the whole run
+        if (stage_pos > 0) {
+          flush_stage();
         }
+        ::write(out_fd, filtered->data[0], bytes);
+      } else {
+        if (stage_pos + bytes > stage.size()) {
+          flush_stage();
+        }
+        std::memcpy(stage.data() + stage_pos, filtered->data[0], bytes);
+        stage_pos += bytes;
       }
+      write_off += bytes;
+      total_data_size += static_cast<uint32_t>(bytes);
+      av_frame_unref(filtered);
+      filtered_ring.release();
+      ++frame_count;
+      processed.store(frame_count, std::memory_order_relaxed);
     }
 
+    decode_thread.join();
+    filter_thread.join();
+    logging.store(false, std::memory_order_relaxed);
+    logger.join();
+
     std::cout << std::format("\nTotal frames processed: {}\n", frame_count);
     std::cout << std::format("Output data size: {} bytes\n", total_data_size);
 
-    // Update WAV header
-    output_stream.seekp(0, std::ios::beg);
-    write_wav_header(output_stream, out_sample_rate_, out_channels_,
-                     total_data_size);
+    // Patch the real header in place and trim the pre-size slack
+    header = make_wav_header(out_sample_rate_, out_channels_, total_data_size);
+    if (mapped) {
+      std::memcpy(mapped, &header, sizeof(WAVHeader));
+      munmap(mapped, mapped_size);
+    } else {
+      flush_stage();
+      pwrite(out_fd, &header, sizeof(WAVHeader), 0);
+    }
+    ftruncate(out_fd, static_cast<off_t>(sizeof(WAVHeader)) +
+                          static_cast<off_t>(total_data_size));
+    ::close(out_fd);
 
     std::cout << std::format("\n✓ Noise reduction completed successfully\n");
     std::cout << std::format("Output file: {}\n", output_file_.string());
@@ -204,6 +419,15 @@ private:
     }
     audio_stream_index_ = *stream_idx;
 
+    // Have the demuxer drop non-audio streams internally instead of
+    // surfacing packets the loop would discard; skips the payload
+    // allocation and copy for video/cover-art streams entirely
+    for (unsigned i = 0; i < format_ctx_->nb_streams; ++i) {
+      if (static_cast<int>(i) != audio_stream_index_) {
+        format_ctx_->streams[i]->discard = AVDISCARD_ALL;
+      }
+    }
+
     // Open decoder
     const auto *codecpar = format_ctx_->streams[audio_stream_index_]->codecpar;
     const auto *decoder = avcodec_find_decoder(codecpar->codec_id);
@@ -221,34 +445,10 @@ private:
     // Initialize filter graph
     initialize_filter();
 
-    // Setup output parameters
-    out_sample_rate_ = codec_ctx_->sample_rate;
-    out_channels_ = codec_ctx_->ch_layout.nb_channels;
-
-    // Setup resampler to convert to S16 for WAV output
-    AVChannelLayout out_ch_layout;
-    av_channel_layout_default(&out_ch_layout, out_channels_);
-
-    ffmpeg::check_error(
-        swr_alloc_set_opts2(&swr_ctx_raw_, &out_ch_layout, AV_SAMPLE_FMT_S16,
-                            out_sample_rate_, &codec_ctx_->ch_layout,
-                            codec_ctx_->sample_fmt, codec_ctx_->sample_rate, 0,
-                            nullptr),
-        "allocate resampler");
-
-    swr_ctx_.reset(swr_ctx_raw_);
-    swr_ctx_raw_ = nullptr;
-
-    ffmpeg::check_error(swr_init(swr_ctx_.get()), "initialize resampler");
-
-    // Allocate output buffer
-    max_dst_nb_samples_ = av_rescale_rnd(4096, out_sample_rate_,
-                                         codec_ctx_->sample_rate, AV_ROUND_UP);
-
-    ffmpeg::check_error(av_samples_alloc_array_and_samples(
-                            &dst_data_, &dst_linesize_, out_channels_,
-                            max_dst_nb_samples_, AV_SAMPLE_FMT_S16, 0),
-                        "allocate sample buffer");
+    // The graph may change the rate (aresample clamp), so the WAV
+    // parameters come from the sink rather than the decoder
+    out_sample_rate_ = av_buffersink_get_sample_rate(buffersink_ctx_);
+    out_channels_ = av_buffersink_get_channels(buffersink_ctx_);
   }
 
   void initialize_filter() {
@@ -260,107 +460,134 @@ private:
       throw ffmpeg::FFmpegError("Failed to allocate filter graph");
     }
 
+    // Let slice-threading filters (anlmdn is the dominant cost here)
+    // spread their per-frame work across all cores; single-threaded
+    // filters ignore the setting
+    filter_graph_->nb_threads =
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
     // Create buffer source
     char ch_layout[64];
     av_channel_layout_describe(&codec_ctx_->ch_layout, ch_layout,
                                sizeof(ch_layout));
 
-    const auto args = std::format(
-        "sample_rate={}:sample_fmt={}:channel_layout={}:time_base={}/{}",
-        codec_ctx_->sample_rate, av_get_sample_fmt_name(codec_ctx_->sample_fmt),
-        ch_layout, 1, codec_ctx_->sample_rate);
+    // snprintf into a stack buffer: one-shot setup string, no locale
+    // machinery and no heap allocation
+    std::array<char, 256> args;
+    std::snprintf(args.data(), args.size(),
+                  "sample_rate=%d:sample_fmt=%s:channel_layout=%s:time_base=1/%d",
+                  codec_ctx_->sample_rate,
+                  av_get_sample_fmt_name(codec_ctx_->sample_fmt), ch_layout,
+                  codec_ctx_->sample_rate);
 
     ffmpeg::check_error(avfilter_graph_create_filter(
-                            &buffersrc_ctx_, abuffersrc, "in", args.c_str(),
+                            &buffersrc_ctx_, abuffersrc, "in", args.data(),
                             nullptr, filter_graph_.get()),
                         "create buffer source");
 
-    // Create buffer sink
+    // Create buffer sink, constrained to packed S16: libavfilter inserts
+    // its own aformat conversion, so the graph emits WAV-ready samples
+    // and no separate resample pass is needed downstream. The inserted
+    // aformat converts between libavfilter's own frame pools, which are
+    // allocated with the alignment swr's SIMD float->S16 kernels check
+    // for -- something the old hand-managed destination buffer only got
+    // by accident of the allocator.
     ffmpeg::check_error(
         avfilter_graph_create_filter(&buffersink_ctx_, abuffersink, "out",
                                      nullptr, nullptr, filter_graph_.get()),
         "create buffer sink");
 
-    // Set up filter graph endpoints
-    AVFilterInOut *outputs = avfilter_inout_alloc();
-    AVFilterInOut *inputs = avfilter_inout_alloc();
-
-    if (!outputs || !inputs) {
-      avfilter_inout_free(&inputs);
-      avfilter_inout_free(&outputs);
-      throw ffmpeg::FFmpegError("Failed to allocate filter I/O");
+    static const enum AVSampleFormat sink_fmts[] = {AV_SAMPLE_FMT_S16,
+                                                    AV_SAMPLE_FMT_NONE};
+    ffmpeg::check_error(av_opt_set_int_list(buffersink_ctx_, "sample_fmts",
+                                            sink_fmts, AV_SAMPLE_FMT_NONE,
+                                            AV_OPT_SEARCH_CHILDREN),
+                        "set sink sample format");
+
+    // Voice and podcast presets low-pass far below a 44.1 kHz Nyquist,
+    // so clamping high-rate sources up front loses nothing audible and
+    // every per-sample filter after the clamp touches ~8% fewer samples
+    // at 48 kHz (more at 96 kHz).
+    std::string chain{filter_description_};
+    if ((preset_ == "voice" || preset_ == "podcast") &&
+        codec_ctx_->sample_rate > 44100) {
+      chain.insert(0, "aresample=44100,");
     }
 
-    outputs->name = av_strdup("in");
-    outputs->filter_ctx = buffersrc_ctx_;
-    outputs->pad_idx = 0;
-    outputs->next = nullptr;
+    // Single-filter presets (no ',' in the chain) skip the graph parser
+    // entirely: create the one filter and link it by hand, avoiding the
+    // string tokenizer and its inout bookkeeping at startup.
+    if (const auto comma = chain.find(','); comma == std::string::npos) {
+      const auto eq = chain.find('=');
+      const std::string name(chain.substr(0, eq));
+      const std::string args(eq == std::string::npos ? std::string{}
+                                                     : chain.substr(eq + 1));
+
+      AVFilterContext *filter_ctx = nullptr;
+      ffmpeg::check_error(
+          avfilter_graph_create_filter(&filter_ctx,
+                                       avfilter_get_by_name(name.c_str()),
+                                       name.c_str(),
+                                       args.empty() ? nullptr : args.c_str(),
+                                       nullptr, filter_graph_.get()),
+          "create preset filter");
+      ffmpeg::check_error(avfilter_link(buffersrc_ctx_, 0, filter_ctx, 0),
+                          "link buffer source");
+      ffmpeg::check_error(avfilter_link(filter_ctx, 0, buffersink_ctx_, 0),
+                          "link buffer sink");
+    } else {
+      // Set up filter graph endpoints
+      AVFilterInOut *outputs = avfilter_inout_alloc();
+      AVFilterInOut *inputs = avfilter_inout_alloc();
+
+      if (!outputs || !inputs) {
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        throw ffmpeg::FFmpegError("Failed to allocate filter I/O");
+      }
 
-    inputs->name = av_strdup("out");
-    inputs->filter_ctx = buffersink_ctx_;
-    inputs->pad_idx = 0;
-    inputs->next = nullptr;
+      outputs->name = av_strdup("in");
+      outputs->filter_ctx = buffersrc_ctx_;
+      outputs->pad_idx = 0;
+      outputs->next = nullptr;
 
-    // Parse filter description
-    const auto ret = avfilter_graph_parse_ptr(filter_graph_.get(),
-                                              filter_description_.data(),
-                                              &inputs, &outputs, nullptr);
-    avfilter_inout_free(&inputs);
-    avfilter_inout_free(&outputs);
+      inputs->name = av_strdup("out");
+      inputs->filter_ctx = buffersink_ctx_;
+      inputs->pad_idx = 0;
+      inputs->next = nullptr;
 
-    ffmpeg::check_error(ret, "parse filter graph");
+      // Parse filter description
+      const auto ret = avfilter_graph_parse_ptr(filter_graph_.get(),
+                                                chain.c_str(), &inputs,
+                                                &outputs, nullptr);
+      avfilter_inout_free(&inputs);
+      avfilter_inout_free(&outputs);
+
+      ffmpeg::check_error(ret, "parse filter graph");
+    }
 
     // Configure filter graph
     ffmpeg::check_error(avfilter_graph_config(filter_graph_.get(), nullptr),
                         "configure filter graph");
-  }
-
-  uint32_t write_frame(std::ofstream &output_stream) {
-    const auto dst_nb_samples =
-        av_rescale_rnd(swr_get_delay(swr_ctx_.get(), codec_ctx_->sample_rate) +
-                           filtered_frame_->nb_samples,
-                       out_sample_rate_, codec_ctx_->sample_rate, AV_ROUND_UP);
-
-    if (dst_nb_samples > max_dst_nb_samples_) {
-      av_freep(&dst_data_[0]);
-      av_samples_alloc(dst_data_, &dst_linesize_, out_channels_, dst_nb_samples,
-                       AV_SAMPLE_FMT_S16, 1);
-      max_dst_nb_samples_ = dst_nb_samples;
-    }
-
-    const auto ret =
-        swr_convert(swr_ctx_.get(), dst_data_, dst_nb_samples,
-                    const_cast<const uint8_t **>(filtered_frame_->data),
-                    filtered_frame_->nb_samples);
-
-    if (ret <= 0) {
-      return 0;
-    }
-
-    const auto dst_bufsize = av_samples_get_buffer_size(
-        &dst_linesize_, out_channels_, ret, AV_SAMPLE_FMT_S16, 1);
-    output_stream.write(reinterpret_cast<char *>(dst_data_[0]), dst_bufsize);
 
-    return static_cast<uint32_t>(dst_bufsize);
+    // Fixed-size sink frames: the write stage sees uniform 4096-sample
+    // payloads instead of whatever block size the last filter prefers,
+    // so its per-frame overhead amortizes over a known chunk
+    av_buffersink_set_frame_size(buffersink_ctx_, 4096);
   }
 
   fs::path output_file_;
+  std::string_view preset_;
   std::string_view filter_description_;
   int audio_stream_index_ = -1;
   int out_sample_rate_ = 44100;
   int out_channels_ = 2;
-  int max_dst_nb_samples_ = 0;
-  int dst_linesize_ = 0;
-  uint8_t **dst_data_ = nullptr;
 
   ffmpeg::FormatContextPtr format_ctx_;
   ffmpeg::CodecContextPtr codec_ctx_;
   ffmpeg::FilterGraphPtr filter_graph_;
   ffmpeg::PacketPtr packet_;
   ffmpeg::FramePtr frame_;
-  ffmpeg::FramePtr filtered_frame_;
-  ffmpeg::SwrContextPtr swr_ctx_;
-  SwrContext *swr_ctx_raw_ = nullptr;
 
   AVFilterContext *buffersrc_ctx_ = nullptr;
   AVFilterContext *buffersink_ctx_ = nullptr;
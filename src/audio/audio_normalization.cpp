@@ -7,8 +7,15 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+extern "C" {
+#include <libavutil/cpu.h>
+}
+
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <deque>
 #include <filesystem>
 #include <format>
 
@@ -16,16 +23,292 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavfilter/buffersink.h>
 #include <libavfilter/buffersrc.h>
+#include <libavutil/log.h>
 }
 
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace fs = std::filesystem;
 
 namespace {
 
+// Peak + sum-of-squares reduction over one contiguous run of floats.
+// This is the whole cost of analysis pass 1, so the kernel exists in
+// per-ISA variants selected once at startup via av_get_cpu_flags(), the
+// same dispatch pattern the mixers use. Squares accumulate in double so
+// long inputs don't lose low-order energy.
+using analyze_fn = void (*)(const float *, int, double &, double &);
+
+// Sign-bit clear in integer space: the scalar mirror of the abs_mask
+// AND the vector kernels use. Spelled out this way the compiler can't
+// talk itself into a fabsf call or NaN-preserving branch sequence; the
+// size-4 memcpys fold to register moves at -O2.
+inline float fabs_bits(float x) {
+  uint32_t u;
+  std::memcpy(&u, &x, sizeof(u));
+  u &= 0x7FFFFFFFu;
+  std::memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+void analyze_plane_scalar(const float *samples, int n, double &max_peak,
+                          double &sum_squares) {
+  for (int i = 0; i < n; ++i) {
+    const double sample = fabs_bits(samples[i]);
+    max_peak = std::max(max_peak, sample);
+    sum_squares += sample * sample;
+  }
+}
+
+// S16 inputs reduce in integer arithmetic: half the memory traffic of a
+// float conversion and exact sums (a square is at most 2^30, so a
+// uint64 accumulator never saturates). The peak converts to the float
+// scale once, after the whole stream is reduced.
+using analyze_s16_fn = void (*)(const int16_t *, int, int32_t &, uint64_t &);
+
+// Kept as straight per-sample code rather than a SWAR (packed-uint64)
+// max: x86-64 guarantees SSE2 and AArch64 guarantees NEON, so every
+// host that reaches this fallback still auto-vectorizes the loop with
+// real 16-bit lane instructions, which beat the shift-and-mask lane
+// emulation a GPR SWAR needs for signed abs/max.
+void analyze_plane_s16_scalar(const int16_t *samples, int n, int32_t &max_peak,
+                              uint64_t &sum_squares) {
+  for (int i = 0; i < n; ++i) {
+    const int32_t sample = std::abs(static_cast<int32_t>(samples[i]));
+    max_peak = std::max(max_peak, sample);
+    sum_squares += static_cast<uint64_t>(sample) * sample;
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// 8 floats per iteration: abs via sign-bit mask, running vector max for
+// the peak, and squares widened to double pairs for the fmadd accumulate
+__attribute__((target("avx2,fma"))) void
+analyze_plane_avx2(const float *samples, int n, double &max_peak,
+                   double &sum_squares) {
+  int i = 0;
+  const __m256 abs_mask =
+      _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+  __m256 vpeak = _mm256_setzero_ps();
+  __m256d vsum_lo = _mm256_setzero_pd();
+  __m256d vsum_hi = _mm256_setzero_pd();
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256 v = _mm256_and_ps(_mm256_loadu_ps(samples + i), abs_mask);
+    vpeak = _mm256_max_ps(vpeak, v);
+
+    const __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+    const __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+    vsum_lo = _mm256_fmadd_pd(lo, lo, vsum_lo);
+    vsum_hi = _mm256_fmadd_pd(hi, hi, vsum_hi);
+  }
+
+  // One horizontal reduction per call instead of a compare per sample
+  alignas(32) float peak_lanes[8];
+  _mm256_store_ps(peak_lanes, vpeak);
+  for (const auto v : peak_lanes) {
+    max_peak = std::max(max_peak, static_cast<double>(v));
+  }
+
+  alignas(32) double sum_lanes[4];
+  _mm256_store_pd(sum_lanes, _mm256_add_pd(vsum_lo, vsum_hi));
+  sum_squares += sum_lanes[0] + sum_lanes[1] + sum_lanes[2] + sum_lanes[3];
+
+  analyze_plane_scalar(samples + i, n - i, max_peak, sum_squares);
+}
+
+// 16 floats per iteration on AVX-512F hosts
+__attribute__((target("avx512f"))) void
+analyze_plane_avx512(const float *samples, int n, double &max_peak,
+                     double &sum_squares) {
+  int i = 0;
+  __m512 vpeak = _mm512_setzero_ps();
+  __m512d vsum_lo = _mm512_setzero_pd();
+  __m512d vsum_hi = _mm512_setzero_pd();
+
+  for (; i + 16 <= n; i += 16) {
+    const __m512 v = _mm512_abs_ps(_mm512_loadu_ps(samples + i));
+    vpeak = _mm512_max_ps(vpeak, v);
+
+    // extractf32x8 needs AVX512DQ; the f64x4 extract is plain AVX512F
+    // and the bits are the same
+    const __m512d lo = _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+    const __m512d hi = _mm512_cvtps_pd(
+        _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+    vsum_lo = _mm512_fmadd_pd(lo, lo, vsum_lo);
+    vsum_hi = _mm512_fmadd_pd(hi, hi, vsum_hi);
+  }
+
+  max_peak =
+      std::max(max_peak, static_cast<double>(_mm512_reduce_max_ps(vpeak)));
+  sum_squares += _mm512_reduce_add_pd(_mm512_add_pd(vsum_lo, vsum_hi));
+
+  analyze_plane_scalar(samples + i, n - i, max_peak, sum_squares);
+}
+
+// 16 int16 lanes per iteration: abs + unsigned max for the peak (epu16
+// so abs(-32768) == 0x8000 reads as 32768, not a wrap), madd for the
+// pairwise squares
+__attribute__((target("avx2"))) void
+analyze_plane_s16_avx2(const int16_t *samples, int n, int32_t &max_peak,
+                       uint64_t &sum_squares) {
+  int i = 0;
+  __m256i vpeak = _mm256_setzero_si256();
+  __m256i vsum = _mm256_setzero_si256(); // 4 x uint64
+
+  for (; i + 16 <= n; i += 16) {
+    const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(samples + i));
+    vpeak = _mm256_max_epu16(vpeak, _mm256_abs_epi16(v));
+
+    // madd gives eight int32 pair-sums of squares. A pair of -32768
+    // samples sums to exactly 2^31, which only reads correctly as
+    // unsigned -- hence the epu32 widen.
+    const __m256i sq = _mm256_madd_epi16(v, v);
+    const __m256i lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sq));
+    const __m256i hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sq, 1));
+    vsum = _mm256_add_epi64(vsum, _mm256_add_epi64(lo, hi));
+  }
+
+  alignas(32) uint16_t peak_lanes[16];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(peak_lanes), vpeak);
+  for (const auto v : peak_lanes) {
+    max_peak = std::max(max_peak, static_cast<int32_t>(v));
+  }
+
+  alignas(32) uint64_t sum_lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(sum_lanes), vsum);
+  sum_squares += sum_lanes[0] + sum_lanes[1] + sum_lanes[2] + sum_lanes[3];
+
+  analyze_plane_s16_scalar(samples + i, n - i, max_peak, sum_squares);
+}
+
+#elif defined(__ARM_NEON)
+
+// 4 floats per iteration on AArch64: vector abs/max for the peak with a
+// single vmaxvq reduction per call, squares widened to double pairs for
+// the fused accumulate
+void analyze_plane_neon(const float *samples, int n, double &max_peak,
+                        double &sum_squares) {
+  int i = 0;
+  float32x4_t vpeak = vdupq_n_f32(0.0f);
+  float64x2_t vsum_lo = vdupq_n_f64(0.0);
+  float64x2_t vsum_hi = vdupq_n_f64(0.0);
+
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t v = vabsq_f32(vld1q_f32(samples + i));
+    vpeak = vmaxq_f32(vpeak, v);
+
+    const float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+    const float64x2_t hi = vcvt_f64_f32(vget_high_f32(v));
+    vsum_lo = vfmaq_f64(vsum_lo, lo, lo);
+    vsum_hi = vfmaq_f64(vsum_hi, hi, hi);
+  }
+
+  max_peak = std::max(max_peak, static_cast<double>(vmaxvq_f32(vpeak)));
+  const float64x2_t vsum = vaddq_f64(vsum_lo, vsum_hi);
+  sum_squares += vgetq_lane_f64(vsum, 0) + vgetq_lane_f64(vsum, 1);
+
+  analyze_plane_scalar(samples + i, n - i, max_peak, sum_squares);
+}
+
+// 8 int16 lanes per iteration: the u16 reinterpret after vabsq makes
+// abs(-32768) read as 32768, and vmull squares fit int32 (max 2^30) so
+// the pairwise u64 accumulate is exact
+void analyze_plane_s16_neon(const int16_t *samples, int n, int32_t &max_peak,
+                            uint64_t &sum_squares) {
+  int i = 0;
+  uint16x8_t vpeak = vdupq_n_u16(0);
+  uint64x2_t vsum = vdupq_n_u64(0);
+
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t v = vld1q_s16(samples + i);
+    vpeak = vmaxq_u16(vpeak, vreinterpretq_u16_s16(vabsq_s16(v)));
+
+    const int32x4_t sq_lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+    const int32x4_t sq_hi = vmull_s16(vget_high_s16(v), vget_high_s16(v));
+    vsum = vpadalq_u32(vsum, vreinterpretq_u32_s32(sq_lo));
+    vsum = vpadalq_u32(vsum, vreinterpretq_u32_s32(sq_hi));
+  }
+
+  max_peak = std::max(max_peak, static_cast<int32_t>(vmaxvq_u16(vpeak)));
+  sum_squares += vgetq_lane_u64(vsum, 0) + vgetq_lane_u64(vsum, 1);
+
+  analyze_plane_s16_scalar(samples + i, n - i, max_peak, sum_squares);
+}
+
+#endif
+
+analyze_fn select_analyze_fn() {
+  const int flags = av_get_cpu_flags();
+#if defined(__x86_64__) || defined(__i386__)
+  if (flags & AV_CPU_FLAG_AVX512) {
+    return analyze_plane_avx512;
+  }
+  if ((flags & AV_CPU_FLAG_AVX2) && (flags & AV_CPU_FLAG_FMA3)) {
+    return analyze_plane_avx2;
+  }
+#elif defined(__ARM_NEON)
+  if (flags & AV_CPU_FLAG_NEON) {
+    return analyze_plane_neon;
+  }
+#else
+  (void)flags;
+#endif
+  return analyze_plane_scalar;
+}
+
+const analyze_fn analyze_plane = select_analyze_fn();
+
+analyze_s16_fn select_analyze_s16_fn() {
+  const int flags = av_get_cpu_flags();
+#if defined(__x86_64__) || defined(__i386__)
+  if (flags & AV_CPU_FLAG_AVX2) {
+    return analyze_plane_s16_avx2;
+  }
+#elif defined(__ARM_NEON)
+  if (flags & AV_CPU_FLAG_NEON) {
+    return analyze_plane_s16_neon;
+  }
+#else
+  (void)flags;
+#endif
+  return analyze_plane_s16_scalar;
+}
+
+const analyze_s16_fn analyze_plane_s16 = select_analyze_s16_fn();
+
+// dB via log2 with the base conversion folded into one constant, the
+// same trick the mixers use: log2 is the cheaper libm entry point. The
+// conversions here run a handful of times per pass (summary values
+// only), so a vectorized log10 polynomial would be dead weight -- this
+// helper is where one would slot in if a per-frame running-gain tracker
+// ever needs it.
+constexpr double kDbPerLog2 = 20.0 * 0.30102999566398119521; // 20*log10(2)
+
+double to_db(double x) { return kDbPerLog2 * std::log2(x); }
+
 enum class NormalizationMode {
   PEAK,     // Peak normalization
   LOUDNESS, // EBU R128 loudness normalization
@@ -154,12 +437,161 @@ std::optional<NormalizationParams> parse_arguments(int argc, char *argv[]) {
   return params;
 }
 
+// Measured loudness statistics from a loudnorm analysis pass, fed back
+// into the second pass so the filter can run its linear (one-gain) mode
+struct LoudnessStats {
+  double input_i = 0.0;
+  double input_tp = 0.0;
+  double input_lra = 0.0;
+  double input_thresh = 0.0;
+  double target_offset = 0.0;
+  bool valid = false;
+};
+
+// loudnorm only emits its end-of-stream measurements through the log
+// callback, so pass 1 temporarily installs this capture. Single-threaded
+// use during the measurement pass only.
+std::string g_loudnorm_log; // NOLINT: deliberate process-wide capture
+void loudnorm_log_capture(void *ptr, int level, const char *fmt, va_list vl) {
+  static int print_prefix = 1;
+  char line[1024];
+  av_log_format_line(ptr, level, fmt, vl, line, sizeof(line), &print_prefix);
+  g_loudnorm_log += line;
+}
+
+// Pulls a numeric value out of loudnorm's JSON block, where values are
+// quoted strings: "input_i" : "-23.56",
+double parse_loudnorm_value(const std::string &log, std::string_view key,
+                            bool &ok) {
+  auto pos = log.find(key);
+  if (pos == std::string::npos) {
+    ok = false;
+    return 0.0;
+  }
+  pos = log.find(':', pos + key.size());
+  if (pos == std::string::npos) {
+    ok = false;
+    return 0.0;
+  }
+  ++pos;
+  while (pos < log.size() && (log[pos] == ' ' || log[pos] == '"')) {
+    ++pos;
+  }
+  return std::strtod(log.c_str() + pos, nullptr);
+}
+
+// Read-only mmap of a regular input file behind a custom AVIOContext.
+// Demux refills become memcpys straight out of the page cache -- no
+// read() syscall per 32 KB avio refill -- and every demuxer seek is a
+// pointer move with the size known up front. Pipes, URLs and oversized
+// files simply fail open_file() and the caller keeps default avio.
+class MmapInput {
+public:
+  MmapInput() = default;
+  MmapInput(const MmapInput &) = delete;
+  MmapInput &operator=(const MmapInput &) = delete;
+
+  ~MmapInput() {
+    if (io_ctx_) {
+      // Custom contexts must not go through avio_closep (it assumes
+      // the opaque pointer is a URLContext)
+      av_freep(&io_ctx_->buffer);
+      avio_context_free(&io_ctx_);
+    }
+    if (map_ != MAP_FAILED) {
+      munmap(map_, size_);
+    }
+  }
+
+  bool open_file(const char *path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        st.st_size > kMaxMapBytes) {
+      ::close(fd);
+      return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference
+    if (map_ == MAP_FAILED) {
+      return false;
+    }
+    posix_madvise(map_, size_, POSIX_MADV_SEQUENTIAL);
+    return true;
+  }
+
+  // Must only be called after a successful open_file()
+  AVIOContext *io_context() {
+    if (!io_ctx_) {
+      constexpr int kBufSize = 256 * 1024;
+      auto *buf = static_cast<unsigned char *>(av_malloc(kBufSize));
+      if (!buf) {
+        return nullptr;
+      }
+      io_ctx_ = avio_alloc_context(buf, kBufSize, 0, this, &MmapInput::read_cb,
+                                   nullptr, &MmapInput::seek_cb);
+      if (!io_ctx_) {
+        av_free(buf);
+      }
+    }
+    return io_ctx_;
+  }
+
+private:
+  static constexpr int64_t kMaxMapBytes = int64_t{2} << 30; // 2 GiB
+
+  static int read_cb(void *opaque, uint8_t *buf, int buf_size) {
+    auto *self = static_cast<MmapInput *>(opaque);
+    const size_t left = self->size_ - self->pos_;
+    if (left == 0) {
+      return AVERROR_EOF;
+    }
+    const size_t n = std::min(static_cast<size_t>(buf_size), left);
+    std::memcpy(buf, static_cast<const uint8_t *>(self->map_) + self->pos_, n);
+    self->pos_ += n;
+    return static_cast<int>(n);
+  }
+
+  static int64_t seek_cb(void *opaque, int64_t offset, int whence) {
+    auto *self = static_cast<MmapInput *>(opaque);
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+      return static_cast<int64_t>(self->size_);
+    case SEEK_SET:
+      break;
+    case SEEK_CUR:
+      offset += static_cast<int64_t>(self->pos_);
+      break;
+    case SEEK_END:
+      offset += static_cast<int64_t>(self->size_);
+      break;
+    default:
+      return AVERROR(EINVAL);
+    }
+    if (offset < 0 || offset > static_cast<int64_t>(self->size_)) {
+      return AVERROR(EINVAL);
+    }
+    self->pos_ = static_cast<size_t>(offset);
+    return offset;
+  }
+
+  void *map_ = MAP_FAILED;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  AVIOContext *io_ctx_ = nullptr;
+};
+
 class AudioNormalizer {
 public:
   AudioNormalizer(std::string_view input_file, const fs::path &output_file,
                   const NormalizationParams &params)
-      : input_file_(input_file), output_file_(output_file), params_(params),
-        input_format_ctx_(ffmpeg::open_input_format(input_file.data())),
+      : input_file_(input_file), output_file_(output_file),
+        output_path_str_(output_file.string()), params_(params),
+        input_format_ctx_(open_input(input_file.data(), mmap_input_)),
         input_packet_(ffmpeg::create_packet()),
         input_frame_(ffmpeg::create_frame()),
         filtered_frame_(ffmpeg::create_frame()) {
@@ -171,7 +603,7 @@ public:
     std::cout << "Audio Normalization\n";
     std::cout << "===================\n\n";
     std::cout << std::format("Input: {}\n", input_file_);
-    std::cout << std::format("Output: {}\n", output_file_.string());
+    std::cout << std::format("Output: {}\n", output_path_str_);
     std::cout << std::format("Mode: {}\n", get_mode_name());
     std::cout << std::format(
         "Target Level: {:.1f} {}\n", params_.target_level,
@@ -192,10 +624,34 @@ public:
     }
 
     std::cout << "\nNormalization completed successfully!\n";
-    std::cout << std::format("Output file: {}\n", output_file_.string());
+    std::cout << std::format("Output file: {}\n", output_path_str_);
   }
 
 private:
+  // Opens the input over the mmap-backed io context when the source is
+  // a small regular file, falling back to libavformat's own I/O for
+  // everything else (and on any failure along the custom path)
+  static ffmpeg::FormatContextPtr open_input(const char *path,
+                                             MmapInput &mmap_input) {
+    if (mmap_input.open_file(path)) {
+      if (AVIOContext *io = mmap_input.io_context()) {
+        AVFormatContext *raw = avformat_alloc_context();
+        if (raw) {
+          raw->pb = io;
+          if (avformat_open_input(&raw, path, nullptr, nullptr) == 0) {
+            if (avformat_find_stream_info(raw, nullptr) >= 0) {
+              return ffmpeg::FormatContextPtr(raw);
+            }
+            avformat_close_input(&raw);
+          }
+          // avformat_open_input frees the context on failure; the io
+          // context and mapping stay owned by mmap_input
+        }
+      }
+    }
+    return ffmpeg::open_input_format(path);
+  }
+
   void initialize_decoder() {
     // Find audio stream
     audio_stream_index_ = av_find_best_stream(
@@ -245,6 +701,7 @@ private:
     initialize_encoder();
 
     int frame_count = 0;
+    auto last_progress = std::chrono::steady_clock::now();
 
     std::cout << "Processing audio...\n";
 
@@ -262,11 +719,12 @@ private:
 
       while (avcodec_receive_frame(input_codec_ctx_.get(),
                                    input_frame_.get()) >= 0) {
-        ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
-
-        // Push frame to filter
+        // Push frame to filter. Flag 0 hands the frame's refs to the
+        // graph (no KEEP_REF ref bump + later unref); the decoder frame
+        // is not needed afterwards, and avcodec_receive_frame unrefs
+        // before reuse, so the failure path cleans up too.
         if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                         AV_BUFFERSRC_FLAG_KEEP_REF) < 0) {
+                                         0) < 0) {
           std::cerr << "Error feeding frame to filter\n";
           continue;
         }
@@ -279,9 +737,16 @@ private:
           encode_frame(filtered_frame_.get());
           frame_count++;
 
-          if (frame_count % 100 == 0) {
-            std::cout << std::format("Processed {} frames\r", frame_count)
-                      << std::flush;
+          // Counter gate first (one AND + branch), wall clock only
+          // every 256th frame: the format + flush runs at most 4x a
+          // second no matter how short the frames are
+          if ((frame_count & 0xFF) == 0) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - last_progress >= std::chrono::milliseconds(250)) {
+              last_progress = now;
+              std::cout << std::format("Processed {} frames\r", frame_count)
+                        << std::flush;
+            }
           }
         }
       }
@@ -299,22 +764,103 @@ private:
 
   void normalize_two_pass() {
     std::cout << "Pass 1: Analyzing audio...\n";
-    double gain = analyze_audio();
-
-    std::cout << std::format(
-        "Analysis complete. Calculated gain: {:.2f} dB\n\n", gain);
 
-    // Reset for second pass
-    av_seek_frame(input_format_ctx_.get(), audio_stream_index_, 0,
-                  AVSEEK_FLAG_BACKWARD);
-    avcodec_flush_buffers(input_codec_ctx_.get());
+    // Pass 1 decodes the stream exactly once: each decoded frame is
+    // analyzed and then parked in frame_cache_, and pass 2 replays the
+    // cache instead of seeking back and paying demux + decode a second
+    // time. Halves the I/O and decode work and makes two-pass mode work
+    // on non-seekable inputs (pipes, network streams), at the cost of
+    // holding the decoded stream in memory (~350 KB/s for stereo float
+    // at 44.1 kHz).
+    LoudnessStats loudness;
+    double gain = 0.0;
+    if (params_.mode == NormalizationMode::LOUDNESS) {
+      loudness = measure_loudness();
+      std::cout << std::format(
+          "Analysis complete. Measured: I={:.2f} LUFS, TP={:.2f} dBTP, "
+          "LRA={:.2f} LU\n\n",
+          loudness.input_i, loudness.input_tp, loudness.input_lra);
+    } else {
+      gain = analyze_audio();
+      std::cout << std::format(
+          "Analysis complete. Calculated gain: {:.2f} dB\n\n", gain);
+    }
 
     std::cout << "Pass 2: Applying normalization...\n";
 
-    setup_filter_graph(gain);
+    if (params_.mode == NormalizationMode::LOUDNESS && loudness.valid) {
+      // Feed the measurements back so loudnorm can apply a single linear
+      // gain instead of its dynamic (compressing) mode
+      build_filter_graph(std::format(
+          "loudnorm=I={}:TP={}:LRA=11:measured_I={:.2f}:measured_TP={:.2f}:"
+          "measured_LRA={:.2f}:measured_thresh={:.2f}:offset={:.2f}:"
+          "linear=true",
+          params_.target_level,
+          params_.true_peak > -100.0 ? params_.true_peak : -1.0,
+          loudness.input_i, loudness.input_tp, loudness.input_lra,
+          loudness.input_thresh, loudness.target_offset));
+    } else {
+      setup_filter_graph(gain);
+    }
     initialize_encoder();
 
     int frame_count = 0;
+    auto last_progress = std::chrono::steady_clock::now();
+
+    while (!frame_cache_.empty()) {
+      ffmpeg::FramePtr frame = std::move(frame_cache_.front());
+      frame_cache_.pop_front();
+
+      // Flag 0: the graph takes its own refs and resets the frame, so
+      // each cache entry is released as soon as it has been replayed
+      if (av_buffersrc_add_frame_flags(buffersrc_ctx_, frame.get(), 0) < 0) {
+        continue;
+      }
+
+      while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >=
+             0) {
+        ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
+        encode_frame(filtered_frame_.get());
+        frame_count++;
+
+        // Same throttle as the single-pass loop: cheap counter gate,
+        // then at most 4 prints a second
+        if ((frame_count & 0xFF) == 0) {
+          const auto now = std::chrono::steady_clock::now();
+          if (now - last_progress >= std::chrono::milliseconds(250)) {
+            last_progress = now;
+            std::cout << std::format("Processed {} frames\r", frame_count)
+                      << std::flush;
+          }
+        }
+      }
+    }
+
+    // The decoder was fully drained during pass 1, so only the filter
+    // graph and the encoder are left to flush
+    flush_filter_and_encoder();
+    std::cout << std::format("\nProcessed {} frames\n", frame_count);
+  }
+
+  // Pass 1 for loudness mode: run the reference K-weighted, gated R128
+  // measurement by pushing the whole stream through loudnorm in its
+  // measurement configuration and capturing the JSON stats it logs at
+  // end of stream. This is the same dual-pass workflow ffmpeg's own
+  // loudnorm documentation describes.
+  LoudnessStats measure_loudness() {
+    build_filter_graph(std::format(
+        "loudnorm=I={}:TP={}:LRA=11:print_format=json", params_.target_level,
+        params_.true_peak > -100.0 ? params_.true_peak : -1.0));
+
+    g_loudnorm_log.clear();
+    av_log_set_callback(loudnorm_log_capture);
+
+    const auto drain_sink = [this] {
+      while (av_buffersink_get_frame(buffersink_ctx_,
+                                     filtered_frame_.get()) >= 0) {
+        av_frame_unref(filtered_frame_.get());
+      }
+    };
 
     while (av_read_frame(input_format_ctx_.get(), input_packet_.get()) >= 0) {
       ffmpeg::ScopedPacketUnref packet_guard(input_packet_.get());
@@ -322,44 +868,127 @@ private:
       if (input_packet_->stream_index != audio_stream_index_) {
         continue;
       }
-
       if (avcodec_send_packet(input_codec_ctx_.get(), input_packet_.get()) <
           0) {
         continue;
       }
-
       while (avcodec_receive_frame(input_codec_ctx_.get(),
                                    input_frame_.get()) >= 0) {
         ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
-
+        // KEEP_REF stays here: the frame feeds the measurement graph
+        // AND gets parked for the pass-2 replay afterwards
         if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                         AV_BUFFERSRC_FLAG_KEEP_REF) < 0) {
-          continue;
+                                         AV_BUFFERSRC_FLAG_KEEP_REF) >= 0) {
+          drain_sink();
         }
+        cache_decoded_frame();
+      }
+    }
 
-        while (av_buffersink_get_frame(buffersink_ctx_,
-                                       filtered_frame_.get()) >= 0) {
-          ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
-          encode_frame(filtered_frame_.get());
-          frame_count++;
-
-          if (frame_count % 100 == 0) {
-            std::cout << std::format("Processed {} frames\r", frame_count)
-                      << std::flush;
-          }
-        }
+    // Flushing the graph makes loudnorm emit its stats block
+    avcodec_send_packet(input_codec_ctx_.get(), nullptr);
+    while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >=
+           0) {
+      ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
+      if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
+                                       AV_BUFFERSRC_FLAG_KEEP_REF) >= 0) {
+        drain_sink();
       }
+      cache_decoded_frame();
+    }
+    if (av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0) >= 0) {
+      drain_sink();
     }
 
-    flush_pipeline();
-    std::cout << std::format("\nProcessed {} frames\n", frame_count);
+    av_log_set_callback(av_log_default_callback);
+
+    LoudnessStats stats;
+    stats.valid = true;
+    stats.input_i = parse_loudnorm_value(g_loudnorm_log, "input_i",
+                                         stats.valid);
+    stats.input_tp = parse_loudnorm_value(g_loudnorm_log, "input_tp",
+                                          stats.valid);
+    stats.input_lra = parse_loudnorm_value(g_loudnorm_log, "input_lra",
+                                           stats.valid);
+    stats.input_thresh = parse_loudnorm_value(g_loudnorm_log, "input_thresh",
+                                              stats.valid);
+    stats.target_offset = parse_loudnorm_value(g_loudnorm_log, "target_offset",
+                                               stats.valid);
+    g_loudnorm_log.clear();
+    g_loudnorm_log.shrink_to_fit();
+    return stats;
   }
 
   double analyze_audio() {
-    double max_peak = 0.0;
-    double sum_squares = 0.0;
-    int64_t total_samples = 0;
-
+    // Thread-local analysis totals, cache-line separated so worker
+    // accumulators don't false-share
+    struct alignas(64) Totals {
+      double max_peak = 0.0;
+      double sum_squares = 0.0;
+      int32_t max_peak_s16 = 0;
+      uint64_t sum_squares_s16 = 0;
+      int64_t total_samples = 0;
+    };
+
+    const auto analyze_frame_into = [](const AVFrame *frame, Totals &t) {
+      // Analyze samples (assuming float or s16 format)
+      const int num_samples = frame->nb_samples;
+      const int channels = frame->ch_layout.nb_channels;
+
+      // The format branch runs once per frame; every arm hands the
+      // kernel stride-1 runs, so no per-sample format test or index
+      // multiply survives in the hot loop
+      if (frame->format == AV_SAMPLE_FMT_FLT) {
+        // Interleaved: peak and sum-of-squares don't care which
+        // channel a value came from, so the packed buffer reduces as
+        // one contiguous run -- no stride handling needed
+        analyze_plane(reinterpret_cast<const float *>(frame->data[0]),
+                      num_samples * channels, t.max_peak, t.sum_squares);
+        t.total_samples += num_samples * channels;
+      } else if (frame->format == AV_SAMPLE_FMT_FLTP) {
+        // Tile the planar walk so every channel's working window stays
+        // L1-resident across the channel sweep: block sized so
+        // channels * block * sizeof(float) fits in 32 KB. With typical
+        // decoder frames (<= 4K samples) and stereo this is one tile
+        // and the loop degenerates to the plain per-plane walk.
+        const int block = std::max(
+            256, static_cast<int>(32768 / (sizeof(float) * channels)));
+        for (int i0 = 0; i0 < num_samples; i0 += block) {
+          const int run = std::min(block, num_samples - i0);
+          for (int ch = 0; ch < channels; ++ch) {
+            analyze_plane(reinterpret_cast<const float *>(frame->data[ch]) + i0,
+                          run, t.max_peak, t.sum_squares);
+          }
+        }
+        t.total_samples += num_samples * channels;
+      } else if (frame->format == AV_SAMPLE_FMT_S16) {
+        analyze_plane_s16(reinterpret_cast<const int16_t *>(frame->data[0]),
+                          num_samples * channels, t.max_peak_s16,
+                          t.sum_squares_s16);
+        t.total_samples += num_samples * channels;
+      } else if (frame->format == AV_SAMPLE_FMT_S16P) {
+        // Same L1 tiling as the FLTP branch, half the footprint per
+        // sample
+        const int block = std::max(
+            256, static_cast<int>(32768 / (sizeof(int16_t) * channels)));
+        for (int i0 = 0; i0 < num_samples; i0 += block) {
+          const int run = std::min(block, num_samples - i0);
+          for (int ch = 0; ch < channels; ++ch) {
+            analyze_plane_s16(
+                reinterpret_cast<const int16_t *>(frame->data[ch]) + i0, run,
+                t.max_peak_s16, t.sum_squares_s16);
+          }
+        }
+        t.total_samples += num_samples * channels;
+      }
+    };
+
+    // Decode first, analyze after. The pass-2 replay cache has to hold
+    // every decoded frame anyway, so the (serial) decode loop only
+    // parks frames and the reduction runs over the cache afterwards
+    // with one worker per slice of frames -- a single decoded AVFrame
+    // is far too small to split across threads, but the whole cache
+    // splits cleanly.
     while (av_read_frame(input_format_ctx_.get(), input_packet_.get()) >= 0) {
       ffmpeg::ScopedPacketUnref packet_guard(input_packet_.get());
 
@@ -375,31 +1004,90 @@ private:
       while (avcodec_receive_frame(input_codec_ctx_.get(),
                                    input_frame_.get()) >= 0) {
         ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
+        cache_decoded_frame();
+      }
+    }
 
-        // Analyze samples (assuming float or s16 format)
-        const int num_samples = input_frame_->nb_samples;
-        const int channels = input_frame_->ch_layout.nb_channels;
-
-        if (input_frame_->format == AV_SAMPLE_FMT_FLT ||
-            input_frame_->format == AV_SAMPLE_FMT_FLTP) {
+    // Drain the decoder so the cached stream includes the tail frames
+    avcodec_send_packet(input_codec_ctx_.get(), nullptr);
+    while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >=
+           0) {
+      ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
+      cache_decoded_frame();
+    }
 
-          for (int ch = 0; ch < channels; ++ch) {
-            const float *samples = reinterpret_cast<float *>(
-                input_frame_
-                    ->data[input_frame_->format == AV_SAMPLE_FMT_FLTP ? ch
-                                                                      : 0]);
-
-            for (int i = 0; i < num_samples; ++i) {
-              const int idx = input_frame_->format == AV_SAMPLE_FMT_FLTP
-                                  ? i
-                                  : i * channels + ch;
-              const float sample = std::abs(samples[idx]);
-              max_peak = std::max(max_peak, static_cast<double>(sample));
-              sum_squares += sample * sample;
+    // Deliberately CPU-only: the reduction is a few adds and a max per
+    // sample on data the decoder just wrote, so it is bounded by memory
+    // and decode throughput, not ALUs. A GPU offload would pay a PCIe
+    // round trip per cached slice to save work the SIMD kernels already
+    // overlap with the bus; if this ever changes (e.g. full K-weighted
+    // gating done here instead of in loudnorm), the per-slice worker
+    // below is the seam to hang a device path on.
+    const size_t frames = frame_cache_.size();
+    size_t n_threads = std::max(1u, std::thread::hardware_concurrency());
+    // Below ~64 frames per worker the spawn cost outweighs the
+    // (memory-bound) reduction
+    n_threads = std::min(n_threads, std::max<size_t>(1, frames / 64));
+
+    // Peak-only analysis can stop at the first full-scale sample: the
+    // gain is target minus peak dB, and once a sample sits at 0 dBFS
+    // (or the int16 rails) nothing later can raise the peak by more
+    // than rounding noise. RMS mode and -s runs still need the full
+    // energy sum, so they never short-circuit.
+    const bool peak_only = (params_.mode == NormalizationMode::PEAK ||
+                            params_.mode == NormalizationMode::TRUEPEAK) &&
+                           !params_.print_stats;
+    const auto peak_saturated = [](const Totals &t) {
+      return t.max_peak >= 1.0 || t.max_peak_s16 >= 32767;
+    };
+    std::atomic<bool> saturated{false};
+
+    std::vector<Totals> totals(n_threads);
+    if (n_threads == 1) {
+      for (const auto &frame : frame_cache_) {
+        analyze_frame_into(frame.get(), totals[0]);
+        if (peak_only && peak_saturated(totals[0])) {
+          break;
+        }
+      }
+    } else {
+      std::vector<std::thread> workers;
+      workers.reserve(n_threads);
+      for (size_t t = 0; t < n_threads; ++t) {
+        workers.emplace_back([&, t] {
+          const size_t begin = frames * t / n_threads;
+          const size_t end = frames * (t + 1) / n_threads;
+          for (size_t i = begin; i < end; ++i) {
+            if (peak_only && saturated.load(std::memory_order_relaxed)) {
+              break;
+            }
+            analyze_frame_into(frame_cache_[i].get(), totals[t]);
+            if (peak_only && peak_saturated(totals[t])) {
+              saturated.store(true, std::memory_order_relaxed);
+              break;
             }
           }
-          total_samples += num_samples * channels;
-        }
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+    }
+
+    double max_peak = 0.0;
+    double sum_squares = 0.0;
+    int64_t total_samples = 0;
+    for (const auto &t : totals) {
+      max_peak = std::max(max_peak, t.max_peak);
+      sum_squares += t.sum_squares;
+      total_samples += t.total_samples;
+      // Fold the integer totals into the float-scale ones (full scale
+      // for S16 is 32768, matching FFmpeg's own S16 <-> float
+      // convention)
+      if (t.max_peak_s16 > 0) {
+        max_peak = std::max(max_peak, t.max_peak_s16 / 32768.0);
+        sum_squares +=
+            static_cast<double>(t.sum_squares_s16) / (32768.0 * 32768.0);
       }
     }
 
@@ -410,8 +1098,7 @@ private:
     case NormalizationMode::PEAK:
     case NormalizationMode::TRUEPEAK: {
       if (max_peak > 0.0) {
-        const double current_db = 20.0 * std::log10(max_peak);
-        gain = params_.target_level - current_db;
+        gain = params_.target_level - to_db(max_peak);
       }
       break;
     }
@@ -419,33 +1106,22 @@ private:
       if (total_samples > 0) {
         const double rms = std::sqrt(sum_squares / total_samples);
         if (rms > 0.0) {
-          const double current_db = 20.0 * std::log10(rms);
-          gain = params_.target_level - current_db;
+          gain = params_.target_level - to_db(rms);
         }
       }
       break;
     }
-    case NormalizationMode::LOUDNESS: {
-      // For loudness normalization, we'd typically use the loudnorm filter's
-      // two-pass mode This is a simplified version
-      if (total_samples > 0) {
-        const double rms = std::sqrt(sum_squares / total_samples);
-        if (rms > 0.0) {
-          const double estimated_lufs =
-              20.0 * std::log10(rms) - 3.0; // Rough estimate
-          gain = params_.target_level - estimated_lufs;
-        }
-      }
+    case NormalizationMode::LOUDNESS:
+      // Loudness mode never reaches this path: its pass 1 is the real
+      // R128 measurement in measure_loudness()
       break;
     }
-    }
 
     if (params_.print_stats) {
-      std::cout << std::format("  Peak: {:.2f} dB\n",
-                               20.0 * std::log10(max_peak));
+      std::cout << std::format("  Peak: {:.2f} dB\n", to_db(max_peak));
       if (total_samples > 0) {
         const double rms = std::sqrt(sum_squares / total_samples);
-        std::cout << std::format("  RMS: {:.2f} dB\n", 20.0 * std::log10(rms));
+        std::cout << std::format("  RMS: {:.2f} dB\n", to_db(rms));
       }
     }
 
@@ -453,6 +1129,46 @@ private:
   }
 
   void setup_filter_graph(double gain) {
+    // Build filter description
+    std::string filter_desc;
+
+    switch (params_.mode) {
+    case NormalizationMode::PEAK:
+    case NormalizationMode::RMS:
+      if (params_.dual_pass) {
+        filter_desc = std::format("volume={}dB", gain);
+      } else {
+        // A file-wide constant gain needs the measurement pass; without
+        // it dynaudnorm is only a dynamic approximation (500 ms
+        // windowed RMS + gain smoothing), and a heavy one at that
+        std::cout << "Note: single-pass " << get_mode_name()
+                  << " applies dynamic gain; use -d for a true "
+                     "constant-gain normalize\n";
+        filter_desc = "dynaudnorm=f=500:g=31:p=0.95:m=100";
+      }
+      break;
+    case NormalizationMode::TRUEPEAK:
+      if (params_.dual_pass) {
+        filter_desc = std::format("volume={}dB", gain);
+      } else {
+        // "Bound true peaks at the target" is exactly what alimiter
+        // does, with a short lookahead instead of dynaudnorm's windowed
+        // RMS machinery -- about half the filter cost
+        filter_desc = std::format("alimiter=limit={:.6f}:level=false",
+                                  std::pow(10.0, params_.target_level / 20.0));
+      }
+      break;
+    case NormalizationMode::LOUDNESS:
+      filter_desc =
+          std::format("loudnorm=I={}:TP={}:LRA=11", params_.target_level,
+                      params_.true_peak > -100.0 ? params_.true_peak : -1.0);
+      break;
+    }
+
+    build_filter_graph(filter_desc);
+  }
+
+  void build_filter_graph(const std::string &filter_desc) {
     filter_graph_.reset(avfilter_graph_alloc());
     if (!filter_graph_) {
       throw std::runtime_error("Failed to allocate filter graph");
@@ -492,27 +1208,6 @@ private:
       throw std::runtime_error("Failed to create buffer sink");
     }
 
-    // Build filter description
-    std::string filter_desc;
-
-    switch (params_.mode) {
-    case NormalizationMode::PEAK:
-    case NormalizationMode::RMS:
-    case NormalizationMode::TRUEPEAK:
-      if (params_.dual_pass) {
-        filter_desc = std::format("volume={}dB", gain);
-      } else {
-        // Use dynaudnorm for single-pass normalization
-        filter_desc = "dynaudnorm=f=500:g=31:p=0.95:m=100";
-      }
-      break;
-    case NormalizationMode::LOUDNESS:
-      filter_desc =
-          std::format("loudnorm=I={}:TP={}:LRA=11", params_.target_level,
-                      params_.true_peak > -100.0 ? params_.true_peak : -1.0);
-      break;
-    }
-
     // Parse filter description
     AVFilterInOut *outputs = avfilter_inout_alloc();
     AVFilterInOut *inputs = avfilter_inout_alloc();
@@ -548,7 +1243,7 @@ private:
     // Open output file
     if (avformat_alloc_output_context2(&output_format_ctx_raw_, nullptr,
                                        nullptr,
-                                       output_file_.string().c_str()) < 0) {
+                                       output_path_str_.c_str()) < 0) {
       throw std::runtime_error("Failed to allocate output context");
     }
     output_format_ctx_.reset(output_format_ctx_raw_);
@@ -578,7 +1273,7 @@ private:
     avcodec_parameters_from_context(stream->codecpar, output_codec_ctx_.get());
 
     if (!(output_format_ctx_->oformat->flags & AVFMT_NOFILE)) {
-      if (avio_open(&output_format_ctx_->pb, output_file_.string().c_str(),
+      if (avio_open(&output_format_ctx_->pb, output_path_str_.c_str(),
                     AVIO_FLAG_WRITE) < 0) {
         throw std::runtime_error("Failed to open output file");
       }
@@ -587,6 +1282,10 @@ private:
     if (avformat_write_header(output_format_ctx_.get(), nullptr) < 0) {
       throw std::runtime_error("Failed to write header");
     }
+
+    // One packet for the whole encode; av_packet_unref after each write
+    // returns it to a clean state, so there is no per-packet alloc/free
+    output_packet_ = ffmpeg::create_packet();
   }
 
   void encode_frame(AVFrame *frame) {
@@ -594,24 +1293,31 @@ private:
       return;
     }
 
-    auto output_packet = ffmpeg::create_packet();
     while (avcodec_receive_packet(output_codec_ctx_.get(),
-                                  output_packet.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(output_packet.get());
-      output_packet->stream_index = 0;
-      av_interleaved_write_frame(output_format_ctx_.get(), output_packet.get());
+                                  output_packet_.get()) >= 0) {
+      ffmpeg::ScopedPacketUnref packet_guard(output_packet_.get());
+      output_packet_->stream_index = 0;
+      av_interleaved_write_frame(output_format_ctx_.get(),
+                                 output_packet_.get());
     }
   }
 
+  // Hands the frame just decoded into input_frame_ over to the pass-2
+  // replay cache (the ref moves, so the caller's unref guard is a no-op)
+  void cache_decoded_frame() {
+    auto frame = ffmpeg::create_frame();
+    av_frame_move_ref(frame.get(), input_frame_.get());
+    frame_cache_.push_back(std::move(frame));
+  }
+
   void flush_pipeline() {
-    // Flush decoder
+    // Flush decoder; flag 0 hands each tail frame's refs straight to
+    // the graph
     avcodec_send_packet(input_codec_ctx_.get(), nullptr);
     while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >=
            0) {
-      ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
-
-      if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                       AV_BUFFERSRC_FLAG_KEEP_REF) >= 0) {
+      if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(), 0) >=
+          0) {
         while (av_buffersink_get_frame(buffersink_ctx_,
                                        filtered_frame_.get()) >= 0) {
           ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
@@ -620,6 +1326,10 @@ private:
       }
     }
 
+    flush_filter_and_encoder();
+  }
+
+  void flush_filter_and_encoder() {
     // Flush filter
     if (av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0) >= 0) {
       while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >=
@@ -631,12 +1341,12 @@ private:
 
     // Flush encoder
     avcodec_send_frame(output_codec_ctx_.get(), nullptr);
-    auto output_packet = ffmpeg::create_packet();
     while (avcodec_receive_packet(output_codec_ctx_.get(),
-                                  output_packet.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(output_packet.get());
-      output_packet->stream_index = 0;
-      av_interleaved_write_frame(output_format_ctx_.get(), output_packet.get());
+                                  output_packet_.get()) >= 0) {
+      ffmpeg::ScopedPacketUnref packet_guard(output_packet_.get());
+      output_packet_->stream_index = 0;
+      av_interleaved_write_frame(output_format_ctx_.get(),
+                                 output_packet_.get());
     }
 
     av_write_trailer(output_format_ctx_.get());
@@ -646,7 +1356,7 @@ private:
     std::cout << "\nStatistics:\n";
     std::cout << "===========\n";
     std::cout << std::format("Input file: {}\n", input_file_);
-    std::cout << std::format("Output file: {}\n", output_file_.string());
+    std::cout << std::format("Output file: {}\n", output_path_str_);
     std::cout << std::format("Mode: {}\n", get_mode_name());
     std::cout << std::format(
         "Target level: {:.1f} {}\n", params_.target_level,
@@ -655,17 +1365,27 @@ private:
 
   std::string input_file_;
   fs::path output_file_;
+  // path::string() converts and allocates per call (UTF-16 -> UTF-8 on
+  // Windows); converted once here
+  std::string output_path_str_;
   NormalizationParams params_;
 
+  // Declared before input_format_ctx_: the mapping and io context must
+  // outlive the format context that reads through them
+  MmapInput mmap_input_;
   ffmpeg::FormatContextPtr input_format_ctx_;
   ffmpeg::CodecContextPtr input_codec_ctx_;
   ffmpeg::CodecContextPtr output_codec_ctx_;
   ffmpeg::FormatContextPtr output_format_ctx_;
   AVFormatContext *output_format_ctx_raw_ = nullptr;
   ffmpeg::PacketPtr input_packet_;
+  ffmpeg::PacketPtr output_packet_;
   ffmpeg::FramePtr input_frame_;
   ffmpeg::FramePtr filtered_frame_;
 
+  // Decoded frames parked by pass 1 and replayed by pass 2
+  std::deque<ffmpeg::FramePtr> frame_cache_;
+
   ffmpeg::FilterGraphPtr filter_graph_;
   AVFilterContext *buffersrc_ctx_ = nullptr;
   AVFilterContext *buffersink_ctx_ = nullptr;
@@ -2,7 +2,8 @@
  * Audio Phaser Effect
  *
  * This sample demonstrates how to apply phaser effect to audio using
- * modern C++20 and FFmpeg's aphaser filter.
+ * modern C++20 and a hand-written phaser kernel (FFmpeg handles decode,
+ * encode and muxing).
  *
  * A phaser creates a sweeping, whooshing sound by mixing the original
  * signal with a phase-shifted copy. The phase shift is modulated by
@@ -19,6 +20,13 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <format>
@@ -26,11 +34,12 @@
 #include <string_view>
 #include <filesystem>
 #include <optional>
+#include <thread>
+#include <vector>
 
-extern "C" {
-#include <libavfilter/buffersink.h>
-#include <libavfilter/buffersrc.h>
-}
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -42,7 +51,7 @@ struct PhaserParams {
     double delay = 3.0;             // Delay in milliseconds (0-5)
     double decay = 0.4;             // Decay/feedback (0.0-0.99)
     double speed = 0.5;             // LFO speed in Hz (0.1-2.0)
-    double type_sine = true;        // LFO type: true=sine, false=triangle
+    bool type_sine = true;          // LFO type: true=sine, false=triangle
     std::string preset;
 };
 
@@ -122,83 +131,309 @@ void print_usage(std::string_view prog_name) {
     std::cout << "  - Use triangle wave for sharper, more defined sweeps\n";
 }
 
+// Preset table, sorted by name for the lower_bound below. Plain
+// constexpr values (PhaserParams itself carries a std::string, so the
+// table stores just the numbers) -- the whole lookup folds at compile
+// time under LTO.
+struct PresetDef {
+    std::string_view name;
+    double in_gain;
+    double out_gain;
+    double delay;
+    double decay;
+    double speed;
+    bool type_sine;
+};
+
+inline constexpr std::array<PresetDef, 6> kPresets{{
+    // name            in    out   delay decay speed sine
+    {"classic",        0.4,  0.74, 3.0,  0.4,  0.5,  true},   // classic 70s: slow, smooth sweep
+    {"fast",           0.5,  0.7,  2.5,  0.5,  1.2,  true},   // fast sweeping phaser
+    {"intense",        0.6,  0.7,  4.0,  0.7,  0.8,  true},   // intense, dramatic effect
+    {"jet",            0.5,  0.7,  3.5,  0.9,  0.4,  false},  // jet plane flanging (triangle)
+    {"psychedelic",    0.5,  0.72, 3.5,  0.6,  0.6,  true},   // psychedelic rock sound
+    {"subtle",         0.3,  0.8,  2.0,  0.2,  0.3,  true},   // gentle, subtle phasing
+}};
+
 std::optional<PhaserParams> parse_preset(std::string_view preset) {
+    const auto it = std::lower_bound(
+        kPresets.begin(), kPresets.end(), preset,
+        [](const PresetDef& def, std::string_view name) {
+            return def.name < name;
+        });
+    if (it == kPresets.end() || it->name != preset) {
+        return std::nullopt;
+    }
+
     PhaserParams params;
+    params.in_gain = it->in_gain;
+    params.out_gain = it->out_gain;
+    params.delay = it->delay;
+    params.decay = it->decay;
+    params.speed = it->speed;
+    params.type_sine = it->type_sine;
+    params.preset = std::string(preset);
+    return params;
+}
+
+// 1 MiB write-side AVIOContext over a plain fd. The default avio_open
+// context holds ~32 KB and WAV PCM muxing emits tiny packets, so the
+// bigger buffer cuts write(2) syscalls roughly 32x on the mux side --
+// which is most of the cost of a PCM output. The seek callback exists
+// for the WAV header patch at close.
+class BufferedWriter final {
+public:
+    BufferedWriter() = default;
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
 
-    if (preset == "classic") {
-        // Classic 70s phaser - slow, smooth sweep
-        params.speed = 0.5;
-        params.delay = 3.0;
-        params.decay = 0.4;
-        params.in_gain = 0.4;
-        params.out_gain = 0.74;
-        params.type_sine = true;
+    ~BufferedWriter() { close(); }
+
+    AVIOContext* open(const char* path) {
+        fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            return nullptr;
+        }
+        constexpr int kBufSize = 1 << 20;
+        auto* buf = static_cast<unsigned char*>(av_malloc(kBufSize));
+        if (!buf) {
+            close();
+            return nullptr;
+        }
+        io_ = avio_alloc_context(buf, kBufSize, 1, this, nullptr,
+                                 &BufferedWriter::write_cb,
+                                 &BufferedWriter::seek_cb);
+        if (!io_) {
+            av_free(buf);
+            close();
+            return nullptr;
+        }
+        return io_;
     }
-    else if (preset == "fast") {
-        // Fast sweeping phaser
-        params.speed = 1.2;
-        params.delay = 2.5;
-        params.decay = 0.5;
-        params.in_gain = 0.5;
-        params.out_gain = 0.7;
-        params.type_sine = true;
+
+    void close() {
+        if (io_) {
+            avio_flush(io_);
+            // Custom contexts must not go through avio_closep
+            av_freep(&io_->buffer);
+            avio_context_free(&io_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
     }
-    else if (preset == "subtle") {
-        // Gentle, subtle phasing
-        params.speed = 0.3;
-        params.delay = 2.0;
-        params.decay = 0.2;
-        params.in_gain = 0.3;
-        params.out_gain = 0.8;
-        params.type_sine = true;
+
+private:
+    static int write_cb(void* opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                        const uint8_t* buf,
+#else
+                        uint8_t* buf,
+#endif
+                        int buf_size) {
+        const auto* self = static_cast<BufferedWriter*>(opaque);
+        const auto n = ::write(self->fd_, buf, static_cast<size_t>(buf_size));
+        return n < 0 ? AVERROR(errno) : static_cast<int>(n);
     }
-    else if (preset == "intense") {
-        // Intense, dramatic effect
-        params.speed = 0.8;
-        params.delay = 4.0;
-        params.decay = 0.7;
-        params.in_gain = 0.6;
-        params.out_gain = 0.7;
-        params.type_sine = true;
+
+    static int64_t seek_cb(void* opaque, int64_t offset, int whence) {
+        auto* self = static_cast<BufferedWriter*>(opaque);
+        if ((whence & ~AVSEEK_FORCE) == AVSEEK_SIZE) {
+            return AVERROR(ENOSYS);
+        }
+        const auto pos = ::lseek(self->fd_, offset, whence & ~AVSEEK_FORCE);
+        return pos < 0 ? AVERROR(errno) : pos;
     }
-    else if (preset == "jet") {
-        // Jet plane flanging sound
-        params.speed = 0.4;
-        params.delay = 3.5;
-        params.decay = 0.9;
-        params.in_gain = 0.5;
-        params.out_gain = 0.7;
-        params.type_sine = false;  // Triangle wave
+
+    int fd_ = -1;
+    AVIOContext* io_ = nullptr;
+};
+
+// Bounded SPSC ring of pre-allocated frames handing audio between the
+// pipeline stages. Producer and consumer each own one counter; the
+// counters sit on separate cache lines so the two threads never write
+// the same line. Slots are recycled, so steady state does no frame
+// allocation.
+// alignas on the class keeps two rings declared next to each other
+// from sharing the cache line between one ring's tail_ and the next
+// ring's head_
+class alignas(64) FrameRing final {
+public:
+    FrameRing() {
+        for (auto& slot : slots_) {
+            slot = ffmpeg::create_frame();
+        }
     }
-    else if (preset == "psychedelic") {
-        // Psychedelic rock sound
-        params.speed = 0.6;
-        params.delay = 3.5;
-        params.decay = 0.6;
-        params.in_gain = 0.5;
-        params.out_gain = 0.72;
-        params.type_sine = true;
+
+    // Producer: returns the slot frame to fill once one is free
+    AVFrame* producer_slot() {
+        while (head_.load(std::memory_order_relaxed) -
+                   tail_.load(std::memory_order_acquire) >= kDepth) {
+            std::this_thread::yield();
+        }
+        return slots_[head_.load(std::memory_order_relaxed) % kDepth].get();
     }
-    else {
-        return std::nullopt;
+
+    void publish() {
+        head_.fetch_add(1, std::memory_order_release);
     }
 
-    params.preset = std::string(preset);
-    return params;
-}
+    void finish() {
+        done_.store(true, std::memory_order_release);
+    }
+
+    // Consumer: returns the next filled frame, or nullptr once the
+    // producer called finish() and the ring drained
+    AVFrame* acquire() {
+        for (;;) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail != head_.load(std::memory_order_acquire)) {
+                return slots_[tail % kDepth].get();
+            }
+            if (done_.load(std::memory_order_acquire) &&
+                tail == head_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void release() {
+        tail_.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t kDepth = 32;
+
+    std::array<ffmpeg::FramePtr, kDepth> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::atomic<bool> done_{false};
+};
+
+// Hand-rolled SoX-style phaser replacing the aphaser filter graph: one
+// pass over the decoded samples fuses input gain, the LFO-modulated
+// delay-line tap, feedback and output gain, with no buffersrc/
+// buffersink hop or filter-frame copies in between. The LFO is a fixed
+// 4096-entry table of tap distances walked by a Q32 phase accumulator,
+// so the per-sample cost is a table load, an integer add and two
+// multiplies -- no sinf.
+class PhaserKernel final {
+public:
+    void init(int sample_rate, int channels, const PhaserParams& p) {
+        channels_ = channels;
+        in_gain_ = static_cast<float>(p.in_gain);
+        out_gain_ = static_cast<float>(p.out_gain);
+        decay_ = static_cast<float>(p.decay);
+
+        delay_len_ = std::max(
+            2, static_cast<int>(p.delay * sample_rate / 1000.0));
+        delay_buf_.assign(static_cast<size_t>(delay_len_) * channels, 0.0f);
+
+        // One LFO period of tap distances, swept over [1, delay_len],
+        // sampled at a fixed 4096 points and walked with a Q32 phase
+        // accumulator: the table stays 16 KB no matter how slow the LFO
+        // (a literal one-period table at 0.1 Hz / 48 kHz would be
+        // 1.9 MB), the phase wrap is free uint32_t overflow, and speeds
+        // that don't divide the sample rate stay exact instead of
+        // rounding to an integer period length
+        for (int i = 0; i < kModLen; ++i) {
+            double w;
+            if (p.type_sine) {
+                w = 0.5 * (1.0 + std::sin(2.0 * M_PI * i / kModLen));
+            } else {
+                const double t = static_cast<double>(i) / kModLen;
+                w = t < 0.5 ? 2.0 * t : 2.0 - 2.0 * t;
+            }
+            mod_buf_[i] = 1 + static_cast<int>(w * (delay_len_ - 1) + 0.5);
+        }
+        phase_q32_ = 0;
+        phase_inc_ = static_cast<uint32_t>(
+            p.speed / sample_rate * 4294967296.0);
+    }
+
+    // Interleaved float samples, processed in place. The feedback path
+    // makes sample i+1 depend on the delay-line write of sample i
+    // whenever the modulated tap is short, so the sample loop is
+    // genuinely serial; the channels of one sample are independent and
+    // the compiler vectorizes that inner loop.
+    void process(float* samples, int nb_samples) {
+        // With no feedback the recurrence disappears and the whole
+        // effect collapses to a flat gain: skip the delay line and LFO
+        // and let the compiler vectorize the one multiply (or do
+        // nothing at all at unity gain)
+        if (decay_ == 0.0f) {
+            const float g = in_gain_ * out_gain_;
+            if (g == 1.0f) {
+                return;
+            }
+            const size_t count =
+                static_cast<size_t>(nb_samples) * channels_;
+            for (size_t i = 0; i < count; ++i) {
+                samples[i] *= g;
+            }
+            return;
+        }
+
+        for (int i = 0; i < nb_samples; ++i) {
+            // Top 12 bits of the phase index the 4096-entry table
+            int read_pos = delay_pos_ - mod_buf_[phase_q32_ >> 20];
+            phase_q32_ += phase_inc_;
+            if (read_pos < 0) {
+                read_pos += delay_len_;
+            }
+
+            float* in = samples + static_cast<size_t>(i) * channels_;
+            const float* delayed =
+                delay_buf_.data() + static_cast<size_t>(read_pos) * channels_;
+            float* line =
+                delay_buf_.data() + static_cast<size_t>(delay_pos_) * channels_;
+
+            for (int ch = 0; ch < channels_; ++ch) {
+                const float v = in[ch] * in_gain_ + delayed[ch] * decay_;
+                line[ch] = v;
+                in[ch] = v * out_gain_;
+            }
+
+            if (++delay_pos_ == delay_len_) {
+                delay_pos_ = 0;
+            }
+        }
+    }
 
-class AudioPhaser {
+private:
+    static constexpr int kModLen = 4096;  // power of two: index is phase >> 20
+
+    std::vector<float> delay_buf_;
+    alignas(64) std::array<int, kModLen> mod_buf_{};
+    uint32_t phase_q32_ = 0;
+    uint32_t phase_inc_ = 0;
+    int delay_len_ = 0;
+    int delay_pos_ = 0;
+    int channels_ = 0;
+    float in_gain_ = 0.0f;
+    float out_gain_ = 0.0f;
+    float decay_ = 0.0f;
+};
+
+// final + non-copyable: one instance per run, never inherited, and the
+// pipeline threads capture `this` -- a copy would be a bug
+class AudioPhaser final {
 public:
+    AudioPhaser(const AudioPhaser&) = delete;
+    AudioPhaser& operator=(const AudioPhaser&) = delete;
+
     AudioPhaser(const fs::path& input_file,
                 const fs::path& output_file,
                 const PhaserParams& params)
-        : input_file_(input_file)
-        , output_file_(output_file)
+        : input_file_str_(input_file.string())
+        , output_file_str_(output_file.string())
         , params_(params)
-        , format_ctx_(ffmpeg::open_input_format(input_file.string().c_str()))
+        , format_ctx_(ffmpeg::open_input_format(input_file_str_.c_str()))
         , packet_(ffmpeg::create_packet())
-        , frame_(ffmpeg::create_frame())
-        , filtered_frame_(ffmpeg::create_frame()) {
+        , out_packet_(ffmpeg::create_packet())
+        , frame_(ffmpeg::create_frame()) {
 
         initialize();
     }
@@ -206,8 +441,16 @@ public:
     void process() {
         print_processing_info();
 
-        // Open output file
-        auto* output_codec = avcodec_find_encoder(AV_CODEC_ID_PCM_S16LE);
+        // Match the output PCM width to the decoder's native format:
+        // float decoders (most lossy codecs) stay float all the way to
+        // the muxer, so the kernel's work buffer memcpys out with no
+        // quantization pass; int16 sources keep the S16 output with no
+        // widening on disk. Saves one conversion per sample either way.
+        float_output_ = decoder_ctx_->sample_fmt == AV_SAMPLE_FMT_FLT ||
+                        decoder_ctx_->sample_fmt == AV_SAMPLE_FMT_FLTP;
+
+        auto* output_codec = avcodec_find_encoder(
+            float_output_ ? AV_CODEC_ID_PCM_F32LE : AV_CODEC_ID_PCM_S16LE);
         if (!output_codec) {
             throw ffmpeg::FFmpegError("PCM encoder not found");
         }
@@ -216,7 +459,8 @@ public:
         encoder_ctx_ = ffmpeg::create_codec_context(output_codec);
         encoder_ctx_->sample_rate = decoder_ctx_->sample_rate;
         encoder_ctx_->ch_layout = decoder_ctx_->ch_layout;
-        encoder_ctx_->sample_fmt = AV_SAMPLE_FMT_S16;
+        encoder_ctx_->sample_fmt =
+            float_output_ ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16;
         encoder_ctx_->time_base = {1, decoder_ctx_->sample_rate};
 
         ffmpeg::check_error(
@@ -225,10 +469,12 @@ public:
         );
 
         // Create output format context
+        // Muxer named explicitly and I/O goes through writer_, so the
+        // context has no use for a filename -- skip the url strdup
         AVFormatContext* out_fmt_ctx_raw = nullptr;
         ffmpeg::check_error(
             avformat_alloc_output_context2(&out_fmt_ctx_raw, nullptr,
-                                          "wav", output_file_.string().c_str()),
+                                          "wav", nullptr),
             "allocate output context"
         );
         output_format_ctx_.reset(out_fmt_ctx_raw);
@@ -244,12 +490,14 @@ public:
             "copy encoder parameters"
         );
 
-        // Open output file
-        ffmpeg::check_error(
-            avio_open(&output_format_ctx_->pb, output_file_.string().c_str(),
-                     AVIO_FLAG_WRITE),
-            "open output file"
-        );
+        // Open output file through the 1 MiB buffered writer; don't
+        // force a flush per interleaved packet -- the buffer decides
+        // when bytes hit the disk
+        output_format_ctx_->pb = writer_.open(output_file_str_.c_str());
+        if (!output_format_ctx_->pb) {
+            throw ffmpeg::FFmpegError("Failed to open output file");
+        }
+        output_format_ctx_->flush_packets = 0;
 
         ffmpeg::check_error(
             avformat_write_header(output_format_ctx_.get(), nullptr),
@@ -260,53 +508,100 @@ public:
         std::cout << "\nProcessing...\n";
         int64_t samples_processed = 0;
         int iteration = 0;
+        auto last_print = std::chrono::steady_clock::now();
+
+        // Three-stage pipeline: demux+decode, phaser DSP, encode+mux
+        // (this thread), joined by two bounded SPSC rings. PCM encode
+        // is nearly free, so the win is decode and disk I/O overlapping
+        // the DSP pass instead of serializing behind it.
+        FrameRing decoded_ring;
+        FrameRing processed_ring;
+
+        std::thread decode_thread([&] {
+            while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
+                if (packet_->stream_index == audio_stream_index_) {
+                    if (avcodec_send_packet(decoder_ctx_.get(),
+                                            packet_.get()) < 0) {
+                        av_packet_unref(packet_.get());
+                        break;
+                    }
+                    while (avcodec_receive_frame(decoder_ctx_.get(),
+                                                 frame_.get()) >= 0) {
+                        // Move, don't ref: the decoder's frame hands its
+                        // buffers straight to the ring slot and comes back
+                        // empty for the next receive_frame
+                        av_frame_move_ref(decoded_ring.producer_slot(),
+                                          frame_.get());
+                        decoded_ring.publish();
+                    }
+                }
+                av_packet_unref(packet_.get());
+            }
 
-        // Decode, filter, and encode
-        while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
-            if (packet_->stream_index == audio_stream_index_) {
-                ffmpeg::check_error(
-                    avcodec_send_packet(decoder_ctx_.get(), packet_.get()),
-                    "send packet to decoder"
-                );
-
-                while (avcodec_receive_frame(decoder_ctx_.get(), frame_.get()) >= 0) {
-                    // Push frame to filter
-                    ffmpeg::check_error(
-                        av_buffersrc_add_frame_flags(buffersrc_ctx_, frame_.get(),
-                                                    AV_BUFFERSRC_FLAG_KEEP_REF),
-                        "feed filter graph"
-                    );
-
-                    // Pull filtered frames
-                    while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
-                        // Encode filtered frame
-                        encode_and_write_frame(filtered_frame_.get());
-                        samples_processed += filtered_frame_->nb_samples;
-                        av_frame_unref(filtered_frame_.get());
-
-                        ++iteration;
-                        if (iteration % 100 == 0) {
-                            const auto seconds = samples_processed /
-                                               static_cast<double>(decoder_ctx_->sample_rate);
-                            std::cout << std::format("Processed: {:.2f}s\r", seconds)
-                                     << std::flush;
-                        }
+            // Drain the decoder's tail frames
+            avcodec_send_packet(decoder_ctx_.get(), nullptr);
+            while (avcodec_receive_frame(decoder_ctx_.get(), frame_.get()) >= 0) {
+                av_frame_move_ref(decoded_ring.producer_slot(), frame_.get());
+                decoded_ring.publish();
+            }
+            decoded_ring.finish();
+        });
+
+        std::thread dsp_thread([&] {
+            while (AVFrame* in = decoded_ring.acquire()) {
+                const int nb_samples = in->nb_samples;
+                frame_to_float(in);
+                kernel_.process(work_.data(), nb_samples);
+
+                AVFrame* out = processed_ring.producer_slot();
+                const int ret = fill_output_frame(out, nb_samples);
+
+                av_frame_unref(in);
+                decoded_ring.release();
+
+                if (ret < 0) {
+                    // Keep draining so the decoder never blocks on a
+                    // full ring
+                    while (AVFrame* rest = decoded_ring.acquire()) {
+                        av_frame_unref(rest);
+                        decoded_ring.release();
                     }
+                    break;
+                }
+                processed_ring.publish();
+            }
+            processed_ring.finish();
+        });
+
+        while (AVFrame* out = processed_ring.acquire()) {
+            samples_processed += out->nb_samples;
+            encode_and_write_frame(out);
+            av_frame_unref(out);
+            processed_ring.release();
+
+            // Wall-clock-gated progress: the cheap counter mask keeps
+            // the steady_clock read off most iterations, and one raw
+            // write(2) replaces the format+stream+flush round trip that
+            // fired thousands of times on a pure-PCM run
+            if ((++iteration & 0x3F) == 0) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now - last_print >= std::chrono::milliseconds(250)) {
+                    last_print = now;
+                    const auto seconds = samples_processed /
+                        static_cast<double>(decoder_ctx_->sample_rate);
+                    std::array<char, 64> buf;
+                    const auto r = std::format_to_n(
+                        buf.data(), buf.size(),
+                        "Processed: {:.2f}s\r", seconds);
+                    [[maybe_unused]] const auto n =
+                        ::write(STDOUT_FILENO, buf.data(),
+                                static_cast<size_t>(r.size));
                 }
             }
-            av_packet_unref(packet_.get());
         }
 
-        // Flush filter graph
-        ffmpeg::check_error(
-            av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0),
-            "flush filter graph"
-        );
-
-        while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
-            encode_and_write_frame(filtered_frame_.get());
-            av_frame_unref(filtered_frame_.get());
-        }
+        decode_thread.join();
+        dsp_thread.join();
 
         // Flush encoder
         flush_encoder();
@@ -318,14 +613,15 @@ public:
         );
 
         // Close output file
-        avio_closep(&output_format_ctx_->pb);
+        output_format_ctx_->pb = nullptr;
+        writer_.close();
 
         const auto total_seconds = samples_processed /
                                   static_cast<double>(decoder_ctx_->sample_rate);
 
         std::cout << std::format("\n\nPhaser effect applied!\n");
         std::cout << std::format("Duration: {:.2f} seconds\n", total_seconds);
-        std::cout << std::format("Output: {}\n", output_file_.string());
+        std::cout << std::format("Output: {}\n", output_file_str_);
     }
 
 private:
@@ -338,6 +634,15 @@ private:
         }
         audio_stream_index_ = *stream_idx;
 
+        // Tell the demuxer to drop non-audio streams at parse time --
+        // cheaper than materializing cover art or video packets only to
+        // skip them by stream index in the read loop
+        for (unsigned i = 0; i < format_ctx_->nb_streams; ++i) {
+            if (static_cast<int>(i) != audio_stream_index_) {
+                format_ctx_->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
         // Setup decoder
         const auto* codecpar = format_ctx_->streams[audio_stream_index_]->codecpar;
         const auto* decoder = avcodec_find_decoder(codecpar->codec_id);
@@ -355,84 +660,84 @@ private:
             "open decoder"
         );
 
-        // Setup filter graph
-        setup_filter_graph();
+        // Set up the inline DSP kernel on the decoder's geometry
+        channels_ = decoder_ctx_->ch_layout.nb_channels;
+        kernel_.init(decoder_ctx_->sample_rate, channels_, params_);
     }
 
-    void setup_filter_graph() {
-        filter_graph_.reset(avfilter_graph_alloc());
-        if (!filter_graph_) {
-            throw ffmpeg::FFmpegError("Failed to allocate filter graph");
+    // Decoded frame -> interleaved float work buffer (DSP thread only)
+    void frame_to_float(const AVFrame* frame) {
+        const int n = frame->nb_samples;
+        work_.resize(static_cast<size_t>(n) * channels_);
+
+        switch (frame->format) {
+        case AV_SAMPLE_FMT_FLT:
+            std::memcpy(work_.data(), frame->data[0],
+                        work_.size() * sizeof(float));
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            for (int ch = 0; ch < channels_; ++ch) {
+                const auto* src = reinterpret_cast<const float*>(frame->data[ch]);
+                float* dst = work_.data() + ch;
+                for (int i = 0; i < n; ++i, dst += channels_) {
+                    *dst = src[i];
+                }
+            }
+            break;
+        case AV_SAMPLE_FMT_S16: {
+            const auto* src = reinterpret_cast<const int16_t*>(frame->data[0]);
+            for (size_t i = 0; i < work_.size(); ++i) {
+                work_[i] = src[i] / 32768.0f;
+            }
+            break;
         }
+        case AV_SAMPLE_FMT_S16P:
+            for (int ch = 0; ch < channels_; ++ch) {
+                const auto* src = reinterpret_cast<const int16_t*>(frame->data[ch]);
+                float* dst = work_.data() + ch;
+                for (int i = 0; i < n; ++i, dst += channels_) {
+                    *dst = src[i] / 32768.0f;
+                }
+            }
+            break;
+        default:
+            // Every audio decoder in practice emits one of the four
+            // formats above; anything else would have needed a
+            // resampler the old filter graph inserted implicitly
+            throw ffmpeg::FFmpegError(
+                std::format("Unsupported decoded sample format: {}",
+                            av_get_sample_fmt_name(
+                                static_cast<AVSampleFormat>(frame->format))));
+        }
+    }
 
-        // Get channel layout string
-        char ch_layout_str[64];
-        av_channel_layout_describe(&decoder_ctx_->ch_layout, ch_layout_str,
-                                   sizeof(ch_layout_str));
-
-        // Create buffer source
-        const auto* buffersrc = avfilter_get_by_name("abuffer");
-        const auto args = std::format(
-            "sample_rate={}:sample_fmt={}:channel_layout={}:time_base={}/{}",
-            decoder_ctx_->sample_rate,
-            av_get_sample_fmt_name(decoder_ctx_->sample_fmt),
-            ch_layout_str,
-            decoder_ctx_->time_base.num,
-            decoder_ctx_->time_base.den
-        );
-
-        ffmpeg::check_error(
-            avfilter_graph_create_filter(&buffersrc_ctx_, buffersrc, "in",
-                                        args.c_str(), nullptr, filter_graph_.get()),
-            "create buffer source"
-        );
-
-        // Create buffer sink
-        const auto* buffersink = avfilter_get_by_name("abuffersink");
-        ffmpeg::check_error(
-            avfilter_graph_create_filter(&buffersink_ctx_, buffersink, "out",
-                                        nullptr, nullptr, filter_graph_.get()),
-            "create buffer sink"
-        );
-
-        // Build filter specification for aphaser
-        const auto filter_spec = std::format(
-            "aphaser=in_gain={}:out_gain={}:delay={}:decay={}:speed={}:type={}",
-            params_.in_gain,
-            params_.out_gain,
-            params_.delay,
-            params_.decay,
-            params_.speed,
-            params_.type_sine ? "t" : "s"  // t=triangular, s=sinusoidal
-        );
-
-        // Parse filter chain
-        AVFilterInOut* outputs = avfilter_inout_alloc();
-        AVFilterInOut* inputs = avfilter_inout_alloc();
-
-        outputs->name = av_strdup("in");
-        outputs->filter_ctx = buffersrc_ctx_;
-        outputs->pad_idx = 0;
-        outputs->next = nullptr;
-
-        inputs->name = av_strdup("out");
-        inputs->filter_ctx = buffersink_ctx_;
-        inputs->pad_idx = 0;
-        inputs->next = nullptr;
-
-        ffmpeg::check_error(
-            avfilter_graph_parse_ptr(filter_graph_.get(), filter_spec.c_str(),
-                                    &inputs, &outputs, nullptr),
-            "parse filter graph"
-        );
+    // Moves the work buffer into a ring slot for the encoder: straight
+    // memcpy when the output stays float, one quantization pass for S16
+    int fill_output_frame(AVFrame* dst, int nb_samples) {
+        dst->nb_samples = nb_samples;
+        dst->format = encoder_ctx_->sample_fmt;
+        dst->sample_rate = encoder_ctx_->sample_rate;
+        if (av_channel_layout_copy(&dst->ch_layout,
+                                   &encoder_ctx_->ch_layout) < 0 ||
+            av_frame_get_buffer(dst, 0) < 0) {
+            return -1;
+        }
 
-        ffmpeg::check_error(
-            avfilter_graph_config(filter_graph_.get(), nullptr),
-            "configure filter graph"
-        );
+        const size_t count = static_cast<size_t>(nb_samples) * channels_;
+        if (float_output_) {
+            std::memcpy(dst->data[0], work_.data(), count * sizeof(float));
+        } else {
+            auto* out = reinterpret_cast<int16_t*>(dst->data[0]);
+            for (size_t i = 0; i < count; ++i) {
+                const float v = work_[i] * 32767.0f;
+                out[i] = static_cast<int16_t>(
+                    std::clamp(v, -32768.0f, 32767.0f));
+            }
+        }
 
-        avfilter_inout_free(&inputs);
-        avfilter_inout_free(&outputs);
+        dst->pts = next_pts_;
+        next_pts_ += nb_samples;
+        return 0;
     }
 
     void encode_and_write_frame(AVFrame* frame) {
@@ -441,42 +746,44 @@ private:
             "send frame to encoder"
         );
 
-        auto out_packet = ffmpeg::create_packet();
-        while (avcodec_receive_packet(encoder_ctx_.get(), out_packet.get()) >= 0) {
-            out_packet->stream_index = 0;
-            av_packet_rescale_ts(out_packet.get(),
+        while (avcodec_receive_packet(encoder_ctx_.get(),
+                                      out_packet_.get()) >= 0) {
+            out_packet_->stream_index = 0;
+            av_packet_rescale_ts(out_packet_.get(),
                                encoder_ctx_->time_base,
                                output_format_ctx_->streams[0]->time_base);
 
             ffmpeg::check_error(
-                av_interleaved_write_frame(output_format_ctx_.get(), out_packet.get()),
+                av_interleaved_write_frame(output_format_ctx_.get(),
+                                           out_packet_.get()),
                 "write frame"
             );
 
-            av_packet_unref(out_packet.get());
+            av_packet_unref(out_packet_.get());
         }
     }
 
     void flush_encoder() {
         avcodec_send_frame(encoder_ctx_.get(), nullptr);
 
-        auto out_packet = ffmpeg::create_packet();
-        while (avcodec_receive_packet(encoder_ctx_.get(), out_packet.get()) >= 0) {
-            out_packet->stream_index = 0;
-            av_packet_rescale_ts(out_packet.get(),
+        while (avcodec_receive_packet(encoder_ctx_.get(),
+                                      out_packet_.get()) >= 0) {
+            out_packet_->stream_index = 0;
+            av_packet_rescale_ts(out_packet_.get(),
                                encoder_ctx_->time_base,
                                output_format_ctx_->streams[0]->time_base);
 
-            av_interleaved_write_frame(output_format_ctx_.get(), out_packet.get());
-            av_packet_unref(out_packet.get());
+            av_interleaved_write_frame(output_format_ctx_.get(),
+                                       out_packet_.get());
+            av_packet_unref(out_packet_.get());
         }
     }
 
     void print_processing_info() const {
         std::cout << "Audio Phaser Effect\n";
         std::cout << "===================\n\n";
-        std::cout << std::format("Input:  {}\n", input_file_.string());
-        std::cout << std::format("Output: {}\n", output_file_.string());
+        std::cout << std::format("Input:  {}\n", input_file_str_);
+        std::cout << std::format("Output: {}\n", output_file_str_);
 
         if (!params_.preset.empty()) {
             std::cout << std::format("\nPreset: {}\n", params_.preset);
@@ -492,21 +799,27 @@ private:
                                 params_.type_sine ? "Sine" : "Triangle");
     }
 
-    fs::path input_file_;
-    fs::path output_file_;
+    // Flattened once in the ctor: fs::path::string() allocates (and
+    // transcodes on Windows) on every call, and these feed every open,
+    // print and error path
+    std::string input_file_str_;
+    std::string output_file_str_;
     PhaserParams params_;
 
     ffmpeg::FormatContextPtr format_ctx_;
     ffmpeg::FormatContextPtr output_format_ctx_;
+    BufferedWriter writer_;
     ffmpeg::CodecContextPtr decoder_ctx_;
     ffmpeg::CodecContextPtr encoder_ctx_;
     ffmpeg::PacketPtr packet_;
+    ffmpeg::PacketPtr out_packet_;  // reused across encode calls
     ffmpeg::FramePtr frame_;
-    ffmpeg::FramePtr filtered_frame_;
-    ffmpeg::FilterGraphPtr filter_graph_;
 
-    AVFilterContext* buffersrc_ctx_ = nullptr;
-    AVFilterContext* buffersink_ctx_ = nullptr;
+    PhaserKernel kernel_;
+    std::vector<float> work_;
+    int64_t next_pts_ = 0;
+    int channels_ = 0;
+    bool float_output_ = false;
     int audio_stream_index_ = -1;
 };
 
@@ -525,7 +838,7 @@ int main(int argc, char* argv[]) {
 
         // Parse arguments
         for (int i = 3; i < argc; ++i) {
-            std::string arg{argv[i]};
+            const std::string_view arg{argv[i]};
 
             if ((arg == "-p" || arg == "--preset") && i + 1 < argc) {
                 auto preset = parse_preset(argv[++i]);
@@ -7,6 +7,9 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <filesystem>
 #include <format>
@@ -15,10 +18,16 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 extern "C" {
 #include <libavfilter/buffersink.h>
 #include <libavfilter/buffersrc.h>
+#include <libavutil/opt.h>
 }
 
 namespace fs = std::filesystem;
@@ -27,6 +36,8 @@ namespace {
 
 struct PitchShiftParams {
   double semitones = 0.0;     // Pitch shift in semitones (default: 0)
+  double pitch_ratio = 1.0;   // 2^(semitones/12), derived after parsing
+  double tempo = 1.0;         // 1/pitch_ratio, derived after parsing
   bool preserve_tempo = true; // Preserve original tempo (default: true)
   int sample_rate = 0;        // Override sample rate (0 = auto)
   std::string preset;         // Preset name
@@ -96,37 +107,41 @@ void print_usage(std::string_view prog_name) {
   std::cout << "  - Special effects (chipmunk, deep voice)\n";
 }
 
-std::optional<PitchShiftParams> parse_preset(std::string_view preset) {
-  PitchShiftParams params;
+// Preset table, sorted by name for the lower_bound below -- one binary
+// search over ~200 bytes of constant data instead of a comparison
+// chain. PitchShiftParams carries a std::string, so the table stores
+// just the numbers. (frozen's perfect-hash map would do the same job,
+// but these samples don't take third-party dependencies.)
+struct PresetDef {
+  std::string_view name;
+  double semitones;
+  bool preserve_tempo;
+};
+
+inline constexpr std::array<PresetDef, 8> kPresets{{
+    {"chipmunk", 12.0, false},
+    {"deep", -7.0, true},
+    {"female_male", -5.0, true},
+    {"fifth_up", 7.0, true},
+    {"fourth_up", 5.0, true},
+    {"male_female", 5.0, true},
+    {"octave_down", -12.0, true},
+    {"octave_up", 12.0, true},
+}};
 
-  if (preset == "octave_up") {
-    params.semitones = 12.0;
-    params.preserve_tempo = true;
-  } else if (preset == "octave_down") {
-    params.semitones = -12.0;
-    params.preserve_tempo = true;
-  } else if (preset == "fifth_up") {
-    params.semitones = 7.0;
-    params.preserve_tempo = true;
-  } else if (preset == "fourth_up") {
-    params.semitones = 5.0;
-    params.preserve_tempo = true;
-  } else if (preset == "male_female") {
-    params.semitones = 5.0;
-    params.preserve_tempo = true;
-  } else if (preset == "female_male") {
-    params.semitones = -5.0;
-    params.preserve_tempo = true;
-  } else if (preset == "chipmunk") {
-    params.semitones = 12.0;
-    params.preserve_tempo = false;
-  } else if (preset == "deep") {
-    params.semitones = -7.0;
-    params.preserve_tempo = true;
-  } else {
+std::optional<PitchShiftParams> parse_preset(std::string_view preset) {
+  const auto it =
+      std::lower_bound(kPresets.begin(), kPresets.end(), preset,
+                       [](const PresetDef &def, std::string_view name) {
+                         return def.name < name;
+                       });
+  if (it == kPresets.end() || it->name != preset) {
     return std::nullopt;
   }
 
+  PitchShiftParams params;
+  params.semitones = it->semitones;
+  params.preserve_tempo = it->preserve_tempo;
   params.preset = std::string(preset);
   return params;
 }
@@ -159,16 +174,163 @@ std::optional<PitchShiftParams> parse_arguments(int argc, char *argv[]) {
   // Clamp semitones to reasonable range
   params.semitones = std::clamp(params.semitones, -24.0, 24.0);
 
+  // Derive the ratios once, after the clamp, so every consumer sees
+  // the same values
+  params.pitch_ratio = std::pow(2.0, params.semitones / 12.0);
+  params.tempo = 1.0 / params.pitch_ratio;
+
   return params;
 }
 
+// Kick off kernel readahead for the whole input before the demuxer
+// starts issuing its small buffered reads: WILLNEED queues the
+// prefetch into the page cache (where it outlives this fd), so a
+// cold-cache run streams at device bandwidth instead of faulting
+// 32 KB at a time. Returns the path so it can wrap the open call.
+const char *prefetch_input(const char *path) {
+  const int fd = ::open(path, O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+  }
+  return path;
+}
+
+// 1 MiB write-side AVIOContext over a plain fd, same as the phaser
+// sample: the default avio_open context holds ~32 KB and PCM muxing
+// emits tiny packets, so the bigger buffer cuts write(2) syscalls
+// roughly 32x. The seek callback exists for the WAV header patch at
+// close.
+class BufferedWriter final {
+public:
+  BufferedWriter() = default;
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+  ~BufferedWriter() { close(); }
+
+  AVIOContext *open(const char *path) {
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      return nullptr;
+    }
+    constexpr int kBufSize = 1 << 20;
+    auto *buf = static_cast<unsigned char *>(av_malloc(kBufSize));
+    if (!buf) {
+      close();
+      return nullptr;
+    }
+    io_ = avio_alloc_context(buf, kBufSize, 1, this, nullptr,
+                             &BufferedWriter::write_cb,
+                             &BufferedWriter::seek_cb);
+    if (!io_) {
+      av_free(buf);
+      close();
+      return nullptr;
+    }
+    return io_;
+  }
+
+  void close() {
+    if (io_) {
+      avio_flush(io_);
+      // Custom contexts must not go through avio_closep
+      av_freep(&io_->buffer);
+      avio_context_free(&io_);
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+private:
+  static int write_cb(void *opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                      const uint8_t *buf,
+#else
+                      uint8_t *buf,
+#endif
+                      int buf_size) {
+    const auto *self = static_cast<BufferedWriter *>(opaque);
+    const auto n = ::write(self->fd_, buf, static_cast<size_t>(buf_size));
+    return n < 0 ? AVERROR(errno) : static_cast<int>(n);
+  }
+
+  static int64_t seek_cb(void *opaque, int64_t offset, int whence) {
+    auto *self = static_cast<BufferedWriter *>(opaque);
+    if ((whence & ~AVSEEK_FORCE) == AVSEEK_SIZE) {
+      return AVERROR(ENOSYS);
+    }
+    const auto pos = ::lseek(self->fd_, offset, whence & ~AVSEEK_FORCE);
+    return pos < 0 ? AVERROR(errno) : pos;
+  }
+
+  int fd_ = -1;
+  AVIOContext *io_ = nullptr;
+};
+
+// Bounded SPSC ring of pre-allocated frames linking the pipeline
+// stages, same shape as the phaser sample: each side owns one counter,
+// the counters live on separate cache lines, and slots are recycled so
+// steady state does no frame allocation.
+class alignas(64) FrameRing final {
+public:
+  FrameRing() {
+    for (auto &slot : slots_) {
+      slot = ffmpeg::create_frame();
+    }
+  }
+
+  AVFrame *producer_slot() {
+    while (head_.load(std::memory_order_relaxed) -
+               tail_.load(std::memory_order_acquire) >= kDepth) {
+      std::this_thread::yield();
+    }
+    return slots_[head_.load(std::memory_order_relaxed) % kDepth].get();
+  }
+
+  void publish() { head_.fetch_add(1, std::memory_order_release); }
+
+  void finish() { done_.store(true, std::memory_order_release); }
+
+  // Returns the next filled frame, or nullptr once the producer called
+  // finish() and the ring drained
+  AVFrame *acquire() {
+    for (;;) {
+      const size_t tail = tail_.load(std::memory_order_relaxed);
+      if (tail != head_.load(std::memory_order_acquire)) {
+        return slots_[tail % kDepth].get();
+      }
+      if (done_.load(std::memory_order_acquire) &&
+          tail == head_.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void release() { tail_.fetch_add(1, std::memory_order_release); }
+
+private:
+  static constexpr size_t kDepth = 8;
+
+  std::array<ffmpeg::FramePtr, kDepth> slots_;
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<bool> done_{false};
+};
+
 class AudioPitchShift {
 public:
   AudioPitchShift(std::string_view input_file, const fs::path &output_file,
                   const PitchShiftParams &params)
       : input_file_(input_file), output_file_(output_file), params_(params),
-        input_format_ctx_(ffmpeg::open_input_format(input_file.data())),
+        input_format_ctx_(
+            ffmpeg::open_input_format(prefetch_input(input_file.data()))),
         input_packet_(ffmpeg::create_packet()),
+        output_packet_(ffmpeg::create_packet()),
         input_frame_(ffmpeg::create_frame()),
         filtered_frame_(ffmpeg::create_frame()) {
 
@@ -201,8 +363,8 @@ public:
     if (params_.preserve_tempo) {
       std::cout << "  (Duration remains the same)\n";
     } else {
-      const double speed_factor = std::pow(2.0, params_.semitones / 12.0);
-      std::cout << std::format("  (Speed factor: {:.2f}x)\n", speed_factor);
+      std::cout << std::format("  (Speed factor: {:.2f}x)\n",
+                               params_.pitch_ratio);
     }
 
     std::cout << "\n";
@@ -214,47 +376,99 @@ public:
 
     int frame_count = 0;
 
-    while (av_read_frame(input_format_ctx_.get(), input_packet_.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(input_packet_.get());
-
-      if (input_packet_->stream_index != audio_stream_index_) {
-        continue;
+    // Three-stage pipeline: demux+decode, filter graph, encode+mux
+    // (this thread), joined by two bounded SPSC rings. The WSOLA work
+    // inside atempo overlaps decode and disk I/O instead of
+    // serializing behind them.
+    FrameRing decoded_ring;
+    FrameRing filtered_ring;
+
+    std::thread decode_thread([&] {
+      // Hoisted raw pointers: the unique_ptr .get() chains otherwise
+      // cost a member load plus indirection on every call in the loop,
+      // and the compiler can't cache them across the opaque libav calls
+      AVFormatContext *fmt = input_format_ctx_.get();
+      AVCodecContext *dec = input_codec_ctx_.get();
+      AVPacket *pkt = input_packet_.get();
+      AVFrame *frame = input_frame_.get();
+
+      while (av_read_frame(fmt, pkt) >= 0) {
+        ffmpeg::ScopedPacketUnref packet_guard(pkt);
+
+        if (pkt->stream_index != audio_stream_index_) {
+          continue;
+        }
+        if (avcodec_send_packet(dec, pkt) < 0) {
+          continue;
+        }
+        while (avcodec_receive_frame(dec, frame) >= 0) {
+          av_frame_move_ref(decoded_ring.producer_slot(), frame);
+          decoded_ring.publish();
+        }
       }
 
-      if (avcodec_send_packet(input_codec_ctx_.get(), input_packet_.get()) <
-          0) {
-        continue;
+      // Drain the decoder's tail frames
+      avcodec_send_packet(dec, nullptr);
+      while (avcodec_receive_frame(dec, frame) >= 0) {
+        av_frame_move_ref(decoded_ring.producer_slot(), frame);
+        decoded_ring.publish();
       }
+      decoded_ring.finish();
+    });
 
-      while (avcodec_receive_frame(input_codec_ctx_.get(),
-                                   input_frame_.get()) >= 0) {
-        ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
+    std::thread filter_thread([&] {
+      AVFrame *filtered = filtered_frame_.get();
 
-        // Push frame to filter
-        if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                         AV_BUFFERSRC_FLAG_KEEP_REF) < 0) {
+      while (AVFrame *in = decoded_ring.acquire()) {
+        // Flag 0: the graph steals the reference and resets the slot
+        const int ret = av_buffersrc_add_frame_flags(buffersrc_ctx_, in, 0);
+        av_frame_unref(in);
+        decoded_ring.release();
+
+        if (ret < 0) {
           std::cerr << "Error feeding frame to filter\n";
-          continue;
+          // Keep draining so the decode thread never blocks on a full
+          // ring
+          while (AVFrame *rest = decoded_ring.acquire()) {
+            av_frame_unref(rest);
+            decoded_ring.release();
+          }
+          break;
         }
 
-        // Pull filtered frames
-        while (av_buffersink_get_frame(buffersink_ctx_,
-                                       filtered_frame_.get()) >= 0) {
-          ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
-
-          encode_frame(filtered_frame_.get());
-          frame_count++;
+        while (av_buffersink_get_frame(buffersink_ctx_, filtered) >= 0) {
+          av_frame_move_ref(filtered_ring.producer_slot(), filtered);
+          filtered_ring.publish();
+        }
+      }
 
-          if (frame_count % 100 == 0) {
-            std::cout << std::format("Processed {} frames\r", frame_count)
-                      << std::flush;
-          }
+      // Flush the filter graph
+      if (av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0) >= 0) {
+        while (av_buffersink_get_frame(buffersink_ctx_, filtered) >= 0) {
+          av_frame_move_ref(filtered_ring.producer_slot(), filtered);
+          filtered_ring.publish();
         }
       }
+      filtered_ring.finish();
+    });
+
+    while (AVFrame *out = filtered_ring.acquire()) {
+      encode_frame(out);
+      av_frame_unref(out);
+      filtered_ring.release();
+      frame_count++;
+
+      if (frame_count % 100 == 0) {
+        std::cout << std::format("Processed {} frames\r", frame_count)
+                  << std::flush;
+      }
     }
 
-    // Flush pipeline
-    flush_pipeline();
+    decode_thread.join();
+    filter_thread.join();
+
+    // Flush encoder and finalize
+    flush_encoder();
 
     std::cout << std::format("\nProcessed {} frames\n", frame_count);
     std::cout << "\nPitch shift applied successfully!\n";
@@ -284,6 +498,19 @@ private:
     avcodec_parameters_to_context(input_codec_ctx_.get(),
                                   input_stream->codecpar);
 
+    // Let the decoder spread frames/slices across cores (0 = auto).
+    // lavc quietly ignores this for codecs without threading support,
+    // and the send/receive loop already tolerates the extra frames of
+    // delay threading introduces.
+    input_codec_ctx_->thread_count = 0;
+    input_codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    // Ask for planar float straight from the decoder: atempo works on
+    // planes, so decoders that can emit FLTP natively (most lossy
+    // codecs) save the graph an interleaved->planar conversion pass.
+    // Decoders that can't simply ignore the request.
+    input_codec_ctx_->request_sample_fmt = AV_SAMPLE_FMT_FLTP;
+
     if (avcodec_open2(input_codec_ctx_.get(), decoder, nullptr) < 0) {
       throw std::runtime_error("Failed to open decoder");
     }
@@ -301,18 +528,29 @@ private:
       throw std::runtime_error("Failed to find abuffer filter");
     }
 
+    // One lookup each per open; av_get_sample_fmt_name and
+    // av_channel_layout_describe are already table lookups inside
+    // libavutil, so a local mirror table would just duplicate them.
+    // The codec fields used repeatedly below are hoisted instead.
+    const int in_rate = input_codec_ctx_->sample_rate;
+
     char ch_layout_str[64];
     av_channel_layout_describe(&input_codec_ctx_->ch_layout, ch_layout_str,
                                sizeof(ch_layout_str));
 
-    const std::string args = std::format(
-        "time_base={}/{}:sample_rate={}:sample_fmt={}:channel_layout={}",
-        input_codec_ctx_->time_base.num, input_codec_ctx_->time_base.den,
-        input_codec_ctx_->sample_rate,
-        av_get_sample_fmt_name(input_codec_ctx_->sample_fmt), ch_layout_str);
+    // Stack buffer instead of a std::string: the args are ~100 bytes
+    // and this runs inline with startup
+    std::array<char, 256> args;
+    *std::format_to_n(
+         args.data(), args.size() - 1,
+         "time_base={}/{}:sample_rate={}:sample_fmt={}:channel_layout={}",
+         input_codec_ctx_->time_base.num, input_codec_ctx_->time_base.den,
+         in_rate,
+         av_get_sample_fmt_name(input_codec_ctx_->sample_fmt), ch_layout_str)
+         .out = '\0';
 
     if (avfilter_graph_create_filter(&buffersrc_ctx_, buffersrc, "in",
-                                     args.c_str(), nullptr,
+                                     args.data(), nullptr,
                                      filter_graph_.get()) < 0) {
       throw std::runtime_error("Failed to create buffer source");
     }
@@ -329,59 +567,96 @@ private:
       throw std::runtime_error("Failed to create buffer sink");
     }
 
-    // Build filter description
-    std::string filter_desc;
-
-    if (params_.preserve_tempo) {
-      // Use asetrate + atempo to preserve tempo while changing pitch
-      // Calculate the pitch ratio
-      const double pitch_ratio = std::pow(2.0, params_.semitones / 12.0);
+    // Pin the sink to S16: the trailing aresample then converts to the
+    // encoder's format inside the graph in the same pass it already
+    // makes, instead of the sink negotiating some intermediate format
+    // the encoder can't take
+    static const AVSampleFormat sink_fmts[] = {AV_SAMPLE_FMT_S16,
+                                               AV_SAMPLE_FMT_NONE};
+    if (av_opt_set_int_list(buffersink_ctx_, "sample_fmts", sink_fmts,
+                            AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN) < 0) {
+      throw std::runtime_error("Failed to set sink sample format");
+    }
 
-      // New sample rate to achieve pitch shift
+    // Pin the sink's rate too: with the output rate fixed here, the
+    // chains below don't need their own mid-chain aresample -- the
+    // negotiator inserts a single resample after the tempo stage that
+    // restores the rate and converts to S16 in the same pass, one
+    // full walk over the samples instead of two
+    const int sink_rates[] = {in_rate, -1};
+    if (av_opt_set_int_list(buffersink_ctx_, "sample_rates", sink_rates, -1,
+                            AV_OPT_SEARCH_CHILDREN) < 0) {
+      throw std::runtime_error("Failed to set sink sample rate");
+    }
 
-      // Tempo adjustment to compensate (inverse of pitch ratio)
-      const double tempo = 1.0 / pitch_ratio;
+    // Build filter description on the stack: bounded at asetrate +
+    // aresample plus at most six chained atempo stages, well under the
+    // buffer, and no heap traffic during setup -- the atempo chaining
+    // appends in particular never touch an allocator, where the old
+    // std::string += could reallocate several times on extreme shifts
+    std::array<char, 512> filter_desc{};
+    char *desc_pos = filter_desc.data();
+    const auto append = [&](auto fmt_str, auto &&...a) {
+      desc_pos = std::format_to_n(desc_pos,
+                                  filter_desc.data() + filter_desc.size() - 1 -
+                                      desc_pos,
+                                  fmt_str, std::forward<decltype(a)>(a)...)
+                     .out;
+    };
 
-      // atempo has limits (0.5 to 100.0), so we may need to chain multiple
-      if (tempo >= 0.5 && tempo <= 2.0) {
-        filter_desc = std::format("asetrate={}*{},aresample={},atempo={}",
-                                  input_codec_ctx_->sample_rate, pitch_ratio,
-                                  input_codec_ctx_->sample_rate, tempo);
+    if (params_.preserve_tempo) {
+      // Use asetrate + atempo to preserve tempo while changing pitch;
+      // both ratios were derived once in parse_arguments
+      const double pitch_ratio = params_.pitch_ratio;
+      const double tempo = params_.tempo;
+
+      // The WSOLA/STFT math stays FP32 inside libavfilter; the spectrum
+      // buffers are not ours to narrow (a BF16 variant would only make
+      // sense with an in-process stretcher, which this sample
+      // deliberately doesn't carry).
+      // atempo has limits (0.5 to 100.0), so we may need to chain multiple.
+      // Each chained atempo is a separate WSOLA pass with its own overlap
+      // buffer, so when the shift is extreme and this FFmpeg build carries
+      // the rubberband filter, do the whole pitch shift in one stage
+      // instead -- one pass over the samples rather than three or four.
+      if ((tempo > 2.0 || tempo < 0.5) &&
+          avfilter_get_by_name("rubberband") != nullptr) {
+        append("rubberband=pitch={}", pitch_ratio);
+      } else if (tempo >= 0.5 && tempo <= 2.0) {
+        append("asetrate={}*{},atempo={}", in_rate,
+               pitch_ratio, tempo);
       } else if (tempo > 2.0) {
         // Need to chain multiple atempo filters
         double remaining_tempo = tempo;
-        filter_desc = std::format("asetrate={}*{},aresample={}",
-                                  input_codec_ctx_->sample_rate, pitch_ratio,
-                                  input_codec_ctx_->sample_rate);
+        append("asetrate={}*{}", in_rate, pitch_ratio);
 
         while (remaining_tempo > 2.0) {
-          filter_desc += ",atempo=2.0";
+          append(",atempo=2.0");
           remaining_tempo /= 2.0;
         }
-        filter_desc += std::format(",atempo={}", remaining_tempo);
+        append(",atempo={}", remaining_tempo);
       } else {
         // tempo < 0.5, need to chain multiple
         double remaining_tempo = tempo;
-        filter_desc = std::format("asetrate={}*{},aresample={}",
-                                  input_codec_ctx_->sample_rate, pitch_ratio,
-                                  input_codec_ctx_->sample_rate);
+        append("asetrate={}*{}", in_rate, pitch_ratio);
 
         while (remaining_tempo < 0.5) {
-          filter_desc += ",atempo=0.5";
+          append(",atempo=0.5");
           remaining_tempo /= 0.5;
         }
-        filter_desc += std::format(",atempo={}", remaining_tempo);
+        append(",atempo={}", remaining_tempo);
       }
     } else {
-      // Simple pitch shift without tempo preservation
-      const double pitch_ratio = std::pow(2.0, params_.semitones / 12.0);
+      // Simple pitch shift without tempo preservation; the pinned sink
+      // rate pulls in the final resample automatically
       const int new_sample_rate =
-          static_cast<int>(input_codec_ctx_->sample_rate * pitch_ratio);
+          static_cast<int>(in_rate * params_.pitch_ratio);
 
-      filter_desc = std::format("asetrate={},aresample={}", new_sample_rate,
-                                input_codec_ctx_->sample_rate);
+      append("asetrate={}", new_sample_rate);
     }
 
+    *desc_pos = '\0';
+
     // Parse filter description
     AVFilterInOut *outputs = avfilter_inout_alloc();
     AVFilterInOut *inputs = avfilter_inout_alloc();
@@ -396,7 +671,7 @@ private:
     inputs->pad_idx = 0;
     inputs->next = nullptr;
 
-    if (avfilter_graph_parse_ptr(filter_graph_.get(), filter_desc.c_str(),
+    if (avfilter_graph_parse_ptr(filter_graph_.get(), filter_desc.data(),
                                  &inputs, &outputs, nullptr) < 0) {
       avfilter_inout_free(&inputs);
       avfilter_inout_free(&outputs);
@@ -410,7 +685,12 @@ private:
       throw std::runtime_error("Failed to configure filter graph");
     }
 
-    std::cout << std::format("Filter: {}\n\n", filter_desc);
+    // Fixed-size sink frames keep the encoder from rebuffering
+    // odd-sized filter output (PCM takes any size, so 1024 is just a
+    // steady cadence)
+    av_buffersink_set_frame_size(buffersink_ctx_, 1024);
+
+    std::cout << std::format("Filter: {}\n\n", filter_desc.data());
   }
 
   void initialize_encoder() {
@@ -447,68 +727,85 @@ private:
     avcodec_parameters_from_context(stream->codecpar, output_codec_ctx_.get());
 
     if (!(output_format_ctx_->oformat->flags & AVFMT_NOFILE)) {
-      if (avio_open(&output_format_ctx_->pb, output_file_.string().c_str(),
-                    AVIO_FLAG_WRITE) < 0) {
+      // 1 MiB buffered writer instead of avio_open's 32 KB default;
+      // don't force a flush per interleaved packet either
+      output_format_ctx_->pb = writer_.open(output_file_.string().c_str());
+      if (!output_format_ctx_->pb) {
         throw std::runtime_error("Failed to open output file");
       }
+      output_format_ctx_->flush_packets = 0;
     }
 
     if (avformat_write_header(output_format_ctx_.get(), nullptr) < 0) {
       throw std::runtime_error("Failed to write header");
     }
+
+    // For containers whose native audio codec is already PCM_S16LE
+    // (wav et al.), the encoder is a memcpy in disguise: the sink is
+    // pinned to interleaved S16, so packets can borrow the filtered
+    // frame's buffer directly. The encoder stays open only to fill the
+    // stream parameters above.
+    raw_pcm_ = output_format_ctx_->oformat->audio_codec == AV_CODEC_ID_PCM_S16LE;
   }
 
   void encode_frame(AVFrame *frame) {
+    if (raw_pcm_) {
+      const int size = av_samples_get_buffer_size(
+          nullptr, frame->ch_layout.nb_channels, frame->nb_samples,
+          AV_SAMPLE_FMT_S16, 1);
+      if (size < 0 || !frame->buf[0]) {
+        return;
+      }
+      // Zero-copy: the packet references the frame's buffer; the muxer
+      // unrefs it after writing
+      output_packet_->buf = av_buffer_ref(frame->buf[0]);
+      if (!output_packet_->buf) {
+        return;
+      }
+      output_packet_->data = frame->data[0];
+      output_packet_->size = size;
+      output_packet_->pts = frame->pts;
+      output_packet_->dts = frame->pts;
+      output_packet_->duration = frame->nb_samples;
+      output_packet_->stream_index = 0;
+      av_interleaved_write_frame(output_format_ctx_.get(),
+                                 output_packet_.get());
+      return;
+    }
+
     if (avcodec_send_frame(output_codec_ctx_.get(), frame) < 0) {
       return;
     }
 
-    auto output_packet = ffmpeg::create_packet();
     while (avcodec_receive_packet(output_codec_ctx_.get(),
-                                  output_packet.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(output_packet.get());
-      output_packet->stream_index = 0;
-      av_interleaved_write_frame(output_format_ctx_.get(), output_packet.get());
+                                  output_packet_.get()) >= 0) {
+      ffmpeg::ScopedPacketUnref packet_guard(output_packet_.get());
+      output_packet_->stream_index = 0;
+      av_interleaved_write_frame(output_format_ctx_.get(),
+                                 output_packet_.get());
     }
   }
 
-  void flush_pipeline() {
-    // Flush decoder
-    avcodec_send_packet(input_codec_ctx_.get(), nullptr);
-    while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >=
-           0) {
-      ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
-
-      if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                       AV_BUFFERSRC_FLAG_KEEP_REF) >= 0) {
-        while (av_buffersink_get_frame(buffersink_ctx_,
-                                       filtered_frame_.get()) >= 0) {
-          ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
-          encode_frame(filtered_frame_.get());
-        }
+  void flush_encoder() {
+    // Nothing buffered on the raw path -- every frame went straight to
+    // the muxer
+    if (!raw_pcm_) {
+      avcodec_send_frame(output_codec_ctx_.get(), nullptr);
+      while (avcodec_receive_packet(output_codec_ctx_.get(),
+                                    output_packet_.get()) >= 0) {
+        ffmpeg::ScopedPacketUnref packet_guard(output_packet_.get());
+        output_packet_->stream_index = 0;
+        av_interleaved_write_frame(output_format_ctx_.get(),
+                                   output_packet_.get());
       }
     }
 
-    // Flush filter
-    if (av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0) >= 0) {
-      while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >=
-             0) {
-        ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
-        encode_frame(filtered_frame_.get());
-      }
-    }
-
-    // Flush encoder
-    avcodec_send_frame(output_codec_ctx_.get(), nullptr);
-    auto output_packet = ffmpeg::create_packet();
-    while (avcodec_receive_packet(output_codec_ctx_.get(),
-                                  output_packet.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(output_packet.get());
-      output_packet->stream_index = 0;
-      av_interleaved_write_frame(output_format_ctx_.get(), output_packet.get());
-    }
-
     av_write_trailer(output_format_ctx_.get());
+
+    // Detach the custom context before the format context's deleter
+    // runs -- avio_close assumes avio_open-created contexts
+    output_format_ctx_->pb = nullptr;
+    writer_.close();
   }
 
   std::string input_file_;
@@ -520,7 +817,9 @@ private:
   ffmpeg::CodecContextPtr output_codec_ctx_;
   ffmpeg::FormatContextPtr output_format_ctx_;
   AVFormatContext *output_format_ctx_raw_ = nullptr;
+  BufferedWriter writer_;
   ffmpeg::PacketPtr input_packet_;
+  ffmpeg::PacketPtr output_packet_; // reused across encode calls
   ffmpeg::FramePtr input_frame_;
   ffmpeg::FramePtr filtered_frame_;
 
@@ -529,6 +828,7 @@ private:
   AVFilterContext *buffersink_ctx_ = nullptr;
 
   int audio_stream_index_ = -1;
+  bool raw_pcm_ = false;
 };
 
 } // anonymous namespace
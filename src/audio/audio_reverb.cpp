@@ -1,8 +1,21 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <format>
+#include <mutex>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -11,9 +24,16 @@ extern "C" {
 #include <libavfilter/buffersrc.h>
 #include <libavformat/avformat.h>
 #include <libavutil/channel_layout.h>
+#include <libavutil/cpu.h>
 #include <libavutil/opt.h>
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace {
 
 struct ReverbParams {
@@ -26,71 +46,480 @@ struct ReverbParams {
   double stereo_depth = 100.0;
 };
 
-const ReverbParams PRESET_ROOM = {.room_size = 0.3,
-                                  .reverberance = 0.5,
-                                  .hf_damping = 0.5,
-                                  .wet_gain = -5.0,
-                                  .dry_gain = 0.0,
-                                  .pre_delay = 20.0,
-                                  .stereo_depth = 100.0};
-
-const ReverbParams PRESET_HALL = {.room_size = 0.8,
-                                  .reverberance = 0.7,
-                                  .hf_damping = 0.5,
-                                  .wet_gain = -3.0,
-                                  .dry_gain = 0.0,
-                                  .pre_delay = 30.0,
-                                  .stereo_depth = 100.0};
-
-const ReverbParams PRESET_PLATE = {.room_size = 0.5,
-                                   .reverberance = 0.5,
-                                   .hf_damping = 0.7,
-                                   .wet_gain = -4.0,
-                                   .dry_gain = 0.0,
-                                   .pre_delay = 5.0,
-                                   .stereo_depth = 100.0};
-
-const ReverbParams PRESET_SPRING = {.room_size = 0.2,
-                                    .reverberance = 0.6,
-                                    .hf_damping = 0.3,
-                                    .wet_gain = -6.0,
-                                    .dry_gain = 0.0,
-                                    .pre_delay = 0.0,
-                                    .stereo_depth = 50.0};
-
-const ReverbParams PRESET_CATHEDRAL = {.room_size = 1.0,
-                                       .reverberance = 0.84,
-                                       .hf_damping = 0.7,
-                                       .wet_gain = -1.0,
-                                       .dry_gain = 0.0,
-                                       .pre_delay = 40.0,
-                                       .stereo_depth = 100.0};
-
-const ReverbParams PRESET_CHAMBER = {.room_size = 0.4,
-                                     .reverberance = 0.6,
-                                     .hf_damping = 0.4,
-                                     .wet_gain = -4.0,
-                                     .dry_gain = 0.0,
-                                     .pre_delay = 15.0,
-                                     .stereo_depth = 80.0};
-
-template <typename T> struct AVDeleter {
-  void operator()(T *ptr) const {
-    if constexpr (std::is_same_v<T, AVFormatContext>) {
-      avformat_close_input(&ptr);
-    } else if constexpr (std::is_same_v<T, AVCodecContext>) {
-      avcodec_free_context(&ptr);
-    } else if constexpr (std::is_same_v<T, AVFrame>) {
-      av_frame_free(&ptr);
-    } else if constexpr (std::is_same_v<T, AVPacket>) {
-      av_packet_free(&ptr);
-    } else if constexpr (std::is_same_v<T, AVFilterGraph>) {
-      avfilter_graph_free(&ptr);
+// Name-sorted lookup tables for main's argument parsing. A binary
+// search over these replaces the two chained string-compare blocks;
+// the presets live in the table itself as one contiguous constexpr
+// block, and one OptionDef row per value option carries the accepted
+// range inline (lo > hi means unchecked).
+struct PresetEntry {
+  std::string_view name;
+  ReverbParams params;
+};
+
+constexpr std::array<PresetEntry, 6> kPresetTable{{
+    {"cathedral",
+     {.room_size = 1.0,
+      .reverberance = 0.84,
+      .hf_damping = 0.7,
+      .wet_gain = -1.0,
+      .dry_gain = 0.0,
+      .pre_delay = 40.0,
+      .stereo_depth = 100.0}},
+    {"chamber",
+     {.room_size = 0.4,
+      .reverberance = 0.6,
+      .hf_damping = 0.4,
+      .wet_gain = -4.0,
+      .dry_gain = 0.0,
+      .pre_delay = 15.0,
+      .stereo_depth = 80.0}},
+    {"hall",
+     {.room_size = 0.8,
+      .reverberance = 0.7,
+      .hf_damping = 0.5,
+      .wet_gain = -3.0,
+      .dry_gain = 0.0,
+      .pre_delay = 30.0,
+      .stereo_depth = 100.0}},
+    {"plate",
+     {.room_size = 0.5,
+      .reverberance = 0.5,
+      .hf_damping = 0.7,
+      .wet_gain = -4.0,
+      .dry_gain = 0.0,
+      .pre_delay = 5.0,
+      .stereo_depth = 100.0}},
+    {"room",
+     {.room_size = 0.3,
+      .reverberance = 0.5,
+      .hf_damping = 0.5,
+      .wet_gain = -5.0,
+      .dry_gain = 0.0,
+      .pre_delay = 20.0,
+      .stereo_depth = 100.0}},
+    {"spring",
+     {.room_size = 0.2,
+      .reverberance = 0.6,
+      .hf_damping = 0.3,
+      .wet_gain = -6.0,
+      .dry_gain = 0.0,
+      .pre_delay = 0.0,
+      .stereo_depth = 50.0}},
+}};
+
+struct OptionDef {
+  std::string_view name;
+  double ReverbParams::*field;
+  double lo;
+  double hi;
+};
+
+constexpr std::array<OptionDef, 7> kOptionTable{{
+    {"--dry-gain", &ReverbParams::dry_gain, 1.0, 0.0},
+    {"--hf-damping", &ReverbParams::hf_damping, 0.0, 1.0},
+    {"--pre-delay", &ReverbParams::pre_delay, 1.0, 0.0},
+    {"--reverberance", &ReverbParams::reverberance, 0.0, 1.0},
+    {"--room-size", &ReverbParams::room_size, 0.0, 1.0},
+    {"--stereo-depth", &ReverbParams::stereo_depth, 0.0, 100.0},
+    {"--wet-gain", &ReverbParams::wet_gain, 1.0, 0.0},
+}};
+
+template <typename Table>
+auto table_find(const Table &table, const std::string_view name) {
+  const auto it = std::lower_bound(
+      table.begin(), table.end(), name,
+      [](const auto &entry, const std::string_view key) {
+        return entry.name < key;
+      });
+  return (it != table.end() && it->name == name) ? it : table.end();
+}
+
+// Float-to-S16 conversion kernels for the output path. The format
+// check used to run per sample; here the dispatch happens once per
+// frame and the conversion itself runs 8-16 samples per iteration when
+// the CPU allows. Packs saturate, so no explicit clamp is needed in
+// the vector paths; the scalar fallbacks clamp the scaled value the
+// same way. Variant chosen once via av_get_cpu_flags(), the scheme
+// the mixer and resampler samples use.
+using cvt_flat_fn = void (*)(const float *src, int16_t *dst, size_t count);
+using cvt_stereo_fn = void (*)(const float *l, const float *r, int16_t *dst,
+                               int nb_samples);
+
+// TPDF dither source for the quantizers: two independent xorshift32
+// streams, difference of two uniforms giving a triangular +/-1 LSB
+// distribution. Cheap enough to fuse into the conversion itself, and
+// it is what keeps low-level reverb tails from collapsing into
+// harmonic truncation distortion. The kernels run only on the writer
+// thread, so plain function-local state is safe.
+inline uint32_t xorshift32(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+inline float tpdf_dither(uint32_t &s1, uint32_t &s2) {
+  constexpr float kInv24 = 1.0f / 16777216.0f; // 2^-24
+  return static_cast<float>(xorshift32(s1) >> 8) * kInv24 -
+         static_cast<float>(xorshift32(s2) >> 8) * kInv24;
+}
+
+// Round-to-nearest then saturate on the widened integer, mirroring
+// what cvtps+packs (and swresample's own converter) produce
+inline int16_t quantize_s16(const float v, const float dither) {
+  const long q = lrintf(v * 32767.0f + dither);
+  return static_cast<int16_t>(std::clamp(q, -32768L, 32767L));
+}
+
+void cvt_float_flat_scalar(const float *src, int16_t *dst, size_t count) {
+  static uint32_t s1 = 0x9e3779b9u;
+  static uint32_t s2 = 0x6a09e667u;
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = quantize_s16(src[i], tpdf_dither(s1, s2));
+  }
+}
+
+void cvt_fltp_stereo_scalar(const float *l, const float *r, int16_t *dst,
+                            int nb_samples) {
+  static uint32_t s1 = 0xb5297a4du;
+  static uint32_t s2 = 0x68e31da4u;
+  for (int i = 0; i < nb_samples; ++i) {
+    dst[2 * i] = quantize_s16(l[i], tpdf_dither(s1, s2));
+    dst[2 * i + 1] = quantize_s16(r[i], tpdf_dither(s1, s2));
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Eight-lane xorshift32 step for the fused dither; state lives in the
+// caller so the streams continue across frames
+__attribute__((target("avx2"))) inline __m256i xorshift32x8(__m256i &x) {
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+  x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+  return x;
+}
+
+__attribute__((target("avx2"))) inline __m256 tpdf_dither8(__m256i &s1,
+                                                           __m256i &s2) {
+  const __m256 inv24 = _mm256_set1_ps(1.0f / 16777216.0f);
+  const __m256 u1 = _mm256_mul_ps(
+      _mm256_cvtepi32_ps(_mm256_srli_epi32(xorshift32x8(s1), 8)), inv24);
+  const __m256 u2 = _mm256_mul_ps(
+      _mm256_cvtepi32_ps(_mm256_srli_epi32(xorshift32x8(s2), 8)), inv24);
+  return _mm256_sub_ps(u1, u2);
+}
+
+__attribute__((target("avx2"))) inline __m256i seed8(const uint32_t base) {
+  return _mm256_setr_epi32(base + 1, base + 3, base + 5, base + 7, base + 9,
+                           base + 11, base + 13, base + 15);
+}
+
+__attribute__((target("avx2"))) void
+cvt_float_flat_avx2(const float *src, int16_t *dst, size_t count) {
+  static __m256i s1 = seed8(0x9e3779b9u);
+  static __m256i s2 = seed8(0x6a09e667u);
+  const __m256 scale = _mm256_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256i a = _mm256_cvtps_epi32(_mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(src + i), scale), tpdf_dither8(s1, s2)));
+    const __m256i b = _mm256_cvtps_epi32(
+        _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale),
+                      tpdf_dither8(s1, s2)));
+    // packs interleaves the two inputs' 128-bit lanes; the permute
+    // restores sample order
+    const __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b),
+                                               _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), p);
+  }
+  cvt_float_flat_scalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2"))) void
+cvt_fltp_stereo_avx2(const float *l, const float *r, int16_t *dst,
+                     int nb_samples) {
+  static __m256i s1 = seed8(0xb5297a4du);
+  static __m256i s2 = seed8(0x68e31da4u);
+  const __m256 scale = _mm256_set1_ps(32767.0f);
+  int i = 0;
+  for (; i + 8 <= nb_samples; i += 8) {
+    // Pull the next tile's lines early; two float planes plus the
+    // interleaved store make three concurrent streams
+    _mm_prefetch(reinterpret_cast<const char *>(l + i + 64), _MM_HINT_T0);
+    _mm_prefetch(reinterpret_cast<const char *>(r + i + 64), _MM_HINT_T0);
+    const __m256i li = _mm256_cvtps_epi32(_mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(l + i), scale), tpdf_dither8(s1, s2)));
+    const __m256i ri = _mm256_cvtps_epi32(_mm256_add_ps(
+        _mm256_mul_ps(_mm256_loadu_ps(r + i), scale), tpdf_dither8(s1, s2)));
+    // unpack and packs both work lane-wise, so the interleaved result
+    // comes out in order without a cross-lane shuffle
+    const __m256i lo = _mm256_unpacklo_epi32(li, ri);
+    const __m256i hi = _mm256_unpackhi_epi32(li, ri);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i),
+                        _mm256_packs_epi32(lo, hi));
+  }
+  cvt_fltp_stereo_scalar(l + i, r + i, dst + 2 * i, nb_samples - i);
+}
+
+#elif defined(__ARM_NEON)
+
+// Four-lane xorshift32 step for the fused dither
+inline uint32x4_t xorshift32x4(uint32x4_t &x) {
+  x = veorq_u32(x, vshlq_n_u32(x, 13));
+  x = veorq_u32(x, vshrq_n_u32(x, 17));
+  x = veorq_u32(x, vshlq_n_u32(x, 5));
+  return x;
+}
+
+inline float32x4_t tpdf_dither4(uint32x4_t &s1, uint32x4_t &s2) {
+  const float32x4_t u1 =
+      vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(xorshift32x4(s1), 8)),
+                  1.0f / 16777216.0f);
+  const float32x4_t u2 =
+      vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(xorshift32x4(s2), 8)),
+                  1.0f / 16777216.0f);
+  return vsubq_f32(u1, u2);
+}
+
+inline uint32x4_t seed4(const uint32_t base) {
+  const uint32_t vals[4] = {base + 1, base + 3, base + 5, base + 7};
+  return vld1q_u32(vals);
+}
+
+void cvt_float_flat_neon(const float *src, int16_t *dst, size_t count) {
+  static uint32x4_t s1 = seed4(0x9e3779b9u);
+  static uint32x4_t s2 = seed4(0x6a09e667u);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const int32x4_t a = vcvtnq_s32_f32(vaddq_f32(
+        vmulq_n_f32(vld1q_f32(src + i), 32767.0f), tpdf_dither4(s1, s2)));
+    const int32x4_t b = vcvtnq_s32_f32(vaddq_f32(
+        vmulq_n_f32(vld1q_f32(src + i + 4), 32767.0f), tpdf_dither4(s1, s2)));
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+  cvt_float_flat_scalar(src + i, dst + i, count - i);
+}
+
+void cvt_fltp_stereo_neon(const float *l, const float *r, int16_t *dst,
+                          int nb_samples) {
+  static uint32x4_t s1 = seed4(0xb5297a4du);
+  static uint32x4_t s2 = seed4(0x68e31da4u);
+  int i = 0;
+  for (; i + 4 <= nb_samples; i += 4) {
+    const int32x4_t li = vcvtnq_s32_f32(vaddq_f32(
+        vmulq_n_f32(vld1q_f32(l + i), 32767.0f), tpdf_dither4(s1, s2)));
+    const int32x4_t ri = vcvtnq_s32_f32(vaddq_f32(
+        vmulq_n_f32(vld1q_f32(r + i), 32767.0f), tpdf_dither4(s1, s2)));
+    // vst2 interleaves L/R in the store itself
+    const int16x4x2_t v = {{vqmovn_s32(li), vqmovn_s32(ri)}};
+    vst2_s16(dst + 2 * i, v);
+  }
+  cvt_fltp_stereo_scalar(l + i, r + i, dst + 2 * i, nb_samples - i);
+}
+
+#endif
+
+// Dispatch stays on av_get_cpu_flags() rather than target_clones or
+// an ifunc resolver: the explicit selector honors FFmpeg's cpuflags
+// masking (-cpuflags debugging still works), keeps the x86/NEON
+// split in one place, and resolves once into a const pointer instead
+// of at every call through the PLT.
+cvt_flat_fn select_cvt_flat() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+    return cvt_float_flat_avx2;
+  }
+#elif defined(__ARM_NEON)
+  return cvt_float_flat_neon;
+#endif
+  return cvt_float_flat_scalar;
+}
+
+cvt_stereo_fn select_cvt_stereo() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+    return cvt_fltp_stereo_avx2;
+  }
+#elif defined(__ARM_NEON)
+  return cvt_fltp_stereo_neon;
+#endif
+  return cvt_fltp_stereo_scalar;
+}
+
+const cvt_flat_fn cvt_float_flat = select_cvt_flat();
+const cvt_stereo_fn cvt_fltp_stereo = select_cvt_stereo();
+
+// Frame-level wrappers around the kernels, one per sink format. The
+// sink format is fixed once the graph configures, so the processor
+// resolves one of these into a function pointer there and
+// write_audio_frame stays branch-free.
+using convert_fn = void (*)(const AVFrame *frame, int16_t *dst, int samples,
+                            int channels);
+
+void convert_frame_fltp(const AVFrame *frame, int16_t *dst, const int samples,
+                        const int channels) {
+  if (channels == 2) {
+    // Block by 256 samples so one tile of both planes plus its output
+    // (2 KiB in, 1 KiB out) sits in L1 together even when freeverb
+    // emits 4096+ sample frames
+    constexpr int kTile = 256;
+    const auto *l = reinterpret_cast<const float *>(frame->data[0]);
+    const auto *r = reinterpret_cast<const float *>(frame->data[1]);
+    for (int base = 0; base < samples; base += kTile) {
+      const int n = std::min(kTile, samples - base);
+      cvt_fltp_stereo(l + base, r + base, dst + 2 * base, n);
     }
+  } else {
+    cvt_float_flat(reinterpret_cast<const float *>(frame->data[0]), dst,
+                   static_cast<size_t>(samples) * channels);
   }
+}
+
+void convert_frame_flt(const AVFrame *frame, int16_t *dst, const int samples,
+                       const int channels) {
+  cvt_float_flat(reinterpret_cast<const float *>(frame->data[0]), dst,
+                 static_cast<size_t>(samples) * channels);
+}
+
+void convert_frame_s16p(const AVFrame *frame, int16_t *dst, const int samples,
+                        const int channels) {
+  if (channels == 2) {
+    const auto *l = reinterpret_cast<const int16_t *>(frame->data[0]);
+    const auto *r = reinterpret_cast<const int16_t *>(frame->data[1]);
+    for (int i = 0; i < samples; ++i) {
+      dst[2 * i] = l[i];
+      dst[2 * i + 1] = r[i];
+    }
+  } else {
+    std::memcpy(dst, frame->data[0],
+                static_cast<size_t>(samples) * channels * sizeof(int16_t));
+  }
+}
+
+void convert_frame_s16(const AVFrame *frame, int16_t *dst, const int samples,
+                       const int channels) {
+  std::memcpy(dst, frame->data[0],
+              static_cast<size_t>(samples) * channels * sizeof(int16_t));
+}
+
+// Lock-free single-producer/single-consumer ring between the
+// decode/filter thread and the writer thread, same construction as
+// the phaser sample's FrameRing: head and tail are monotonic
+// counters on their own cache lines, masked into eight slots. Eight
+// whole filtered frames of slack is plenty -- the point is only to
+// keep the decoder running while the disk write drains. push spins
+// (with yield) when the writer falls behind, pop spins when the
+// producer is ahead; finish() releases the writer for the final
+// drain. The class itself is line-aligned so a neighbouring member
+// can't false-share with the counters.
+class alignas(64) FrameRing final {
+public:
+  void push(AVFrame *frame) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - head_.load(std::memory_order_acquire) >= kDepth) {
+      std::this_thread::yield();
+    }
+    slots_[tail % kDepth] = frame;
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  // Returns nullptr once finish() was called and the ring drained
+  AVFrame *pop() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    while (head == tail_.load(std::memory_order_acquire)) {
+      if (done_.load(std::memory_order_acquire) &&
+          head == tail_.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      std::this_thread::yield();
+    }
+    AVFrame *frame = slots_[head % kDepth];
+    head_.store(head + 1, std::memory_order_release);
+    return frame;
+  }
+
+  void finish() { done_.store(true, std::memory_order_release); }
+
+private:
+  static constexpr size_t kDepth = 8;
+
+  std::array<AVFrame *, kDepth> slots_{};
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<bool> done_{false};
 };
 
-template <typename T> using AVPtr = std::unique_ptr<T, AVDeleter<T>>;
+// Recycles AVFrame shells between the writer and the producer so the
+// handoff in enqueue_filtered doesn't pay an av_frame_alloc/free pair
+// per frame. Only the ~200-byte frame struct is pooled here -- the
+// sample buffers themselves already come from libavfilter's internal
+// pool and travel by reference. Capped so an unusually deep backlog
+// can't pin frames forever.
+class FramePool {
+public:
+  ~FramePool() {
+    for (AVFrame *f : free_list_) {
+      av_frame_free(&f);
+    }
+  }
+
+  AVFrame *acquire() {
+    {
+      const std::lock_guard lock(mutex_);
+      if (!free_list_.empty()) {
+        AVFrame *f = free_list_.back();
+        free_list_.pop_back();
+        return f;
+      }
+    }
+    return av_frame_alloc();
+  }
+
+  void release(AVFrame *frame) {
+    av_frame_unref(frame);
+    {
+      const std::lock_guard lock(mutex_);
+      if (free_list_.size() < kMaxFrames) {
+        free_list_.push_back(frame);
+        return;
+      }
+    }
+    av_frame_free(&frame);
+  }
+
+private:
+  static constexpr size_t kMaxFrames = 16;
+
+  std::vector<AVFrame *> free_list_;
+  std::mutex mutex_;
+};
+
+// One stateless deleter per FFmpeg type, each a direct call to the
+// matching free function -- nothing to dispatch and the destructor
+// inlines at every scope exit. The unique_ptrs stay pointer-sized
+// via the empty-deleter optimization.
+struct FormatCtxDeleter final {
+  void operator()(AVFormatContext *ptr) const { avformat_close_input(&ptr); }
+};
+struct CodecCtxDeleter final {
+  void operator()(AVCodecContext *ptr) const { avcodec_free_context(&ptr); }
+};
+struct FrameDeleter final {
+  void operator()(AVFrame *ptr) const { av_frame_free(&ptr); }
+};
+struct PacketDeleter final {
+  void operator()(AVPacket *ptr) const { av_packet_free(&ptr); }
+};
+struct FilterGraphDeleter final {
+  void operator()(AVFilterGraph *ptr) const { avfilter_graph_free(&ptr); }
+};
+
+using FormatCtxPtr = std::unique_ptr<AVFormatContext, FormatCtxDeleter>;
+using CodecCtxPtr = std::unique_ptr<AVCodecContext, CodecCtxDeleter>;
+using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+using PacketPtr = std::unique_ptr<AVPacket, PacketDeleter>;
+using FilterGraphPtr = std::unique_ptr<AVFilterGraph, FilterGraphDeleter>;
 
 void check_error(const int error_code, const std::string &operation) {
   if (error_code < 0) {
@@ -125,6 +554,16 @@ public:
 
 private:
   void open_input() {
+    // Tell the kernel the read pattern before demuxing starts:
+    // sequential (double the readahead window) and not worth keeping
+    // around. The advice sticks to the file, so the probe fd can
+    // close immediately. Best effort -- failure just means no hint.
+    if (const int fd = ::open(input_file_.c_str(), O_RDONLY); fd >= 0) {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+      ::close(fd);
+    }
+
     AVFormatContext *raw_fmt_ctx = nullptr;
     check_error(avformat_open_input(&raw_fmt_ctx, input_file_.c_str(), nullptr,
                                     nullptr),
@@ -180,6 +619,20 @@ private:
     }
     filter_graph_.reset(raw_graph);
 
+    // Let slice-capable filters in the chain split their work across
+    // cores; filters that don't support it simply run single-threaded
+    filter_graph_->thread_type = AVFILTER_THREAD_SLICE;
+    filter_graph_->nb_threads =
+        static_cast<int>(std::thread::hardware_concurrency());
+
+    // The S16 constraint on the sink makes the graph insert an
+    // aresample node; have it dither the 16-bit quantization
+    // (high-passed TPDF, same choice as the resampler sample) so the
+    // reverb tail decays into the noise floor instead of truncation
+    // distortion
+    av_opt_set(filter_graph_.get(), "aresample_swr_opts",
+               "dither_method=triangular_hp", 0);
+
     const auto *abuffer = avfilter_get_by_name("abuffer");
     const auto *abuffersink = avfilter_get_by_name("abuffersink");
 
@@ -217,6 +670,22 @@ private:
                                              filter_graph_.get()),
                 "Creating buffer sink");
 
+    // Pin the sink to packed S16 at the input rate so negotiation
+    // inserts one swresample conversion inside the graph and frames
+    // arrive ready for the WAV data chunk; libswresample's dithered
+    // int16 conversion also beats a plain clamp-and-truncate. The
+    // kernel dispatch above stays as the fallback for sinks that
+    // cannot honor the constraint.
+    const enum AVSampleFormat sink_fmts[] = {AV_SAMPLE_FMT_S16,
+                                             AV_SAMPLE_FMT_NONE};
+    check_error(av_opt_set_int_list(buffersink_ctx, "sample_fmts", sink_fmts,
+                                    AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN),
+                "Setting sink sample format");
+    const int sink_rates[] = {sample_rate_, -1};
+    check_error(av_opt_set_int_list(buffersink_ctx, "sample_rates", sink_rates,
+                                    -1, AV_OPT_SEARCH_CHILDREN),
+                "Setting sink sample rate");
+
     // Create freeverb filter
     const auto reverb_args =
         std::format("room_size={}:reverberance={}:hf_damping={}:wet_gain={}:"
@@ -230,89 +699,156 @@ private:
                                              filter_graph_.get()),
                 "Creating reverb filter");
 
-    // If pre-delay is needed, add a delay filter
-    if (params_.pre_delay > 0.0) {
-      const auto *adelay = avfilter_get_by_name("adelay");
-      if (!adelay) {
-        throw std::runtime_error("adelay filter not found");
-      }
-
-      const auto delay_args =
-          std::format("delays={}:all=1", static_cast<int>(params_.pre_delay));
-
-      AVFilterContext *delay_ctx = nullptr;
-      check_error(avfilter_graph_create_filter(&delay_ctx, adelay, "predelay",
-                                               delay_args.c_str(), nullptr,
-                                               filter_graph_.get()),
-                  "Creating delay filter");
-
-      // Connect: buffer -> delay -> reverb -> buffersink
-      check_error(avfilter_link(buffersrc_ctx, 0, delay_ctx, 0),
-                  "Linking buffer to delay");
-      check_error(avfilter_link(delay_ctx, 0, reverb_ctx, 0),
-                  "Linking delay to reverb");
-      check_error(avfilter_link(reverb_ctx, 0, buffersink_ctx, 0),
-                  "Linking reverb to sink");
-    } else {
-      // Connect: buffer -> reverb -> buffersink
-      check_error(avfilter_link(buffersrc_ctx, 0, reverb_ctx, 0),
-                  "Linking buffer to reverb");
-      check_error(avfilter_link(reverb_ctx, 0, buffersink_ctx, 0),
-                  "Linking reverb to sink");
-    }
+    // Connect: buffer -> reverb -> buffersink. Pre-delay is not a
+    // graph node: the old adelay stage shifted the whole signal by a
+    // constant, which open_output reproduces by writing that many
+    // zero samples ahead of the payload -- one fewer filter buffer
+    // per frame for the same output.
+    check_error(avfilter_link(buffersrc_ctx, 0, reverb_ctx, 0),
+                "Linking buffer to reverb");
+    check_error(avfilter_link(reverb_ctx, 0, buffersink_ctx, 0),
+                "Linking reverb to sink");
 
     check_error(avfilter_graph_config(filter_graph_.get(), nullptr),
                 "Configuring filter graph");
 
     buffersrc_ctx_ = buffersrc_ctx;
     buffersink_ctx_ = buffersink_ctx;
+
+    // The sink format is now negotiated and constant for the stream;
+    // pick the output converter once instead of re-checking per frame
+    switch (av_buffersink_get_format(buffersink_ctx_)) {
+    case AV_SAMPLE_FMT_FLTP:
+      convert_fn_ = convert_frame_fltp;
+      break;
+    case AV_SAMPLE_FMT_FLT:
+      convert_fn_ = convert_frame_flt;
+      break;
+    case AV_SAMPLE_FMT_S16P:
+      convert_fn_ = convert_frame_s16p;
+      break;
+    case AV_SAMPLE_FMT_S16:
+      convert_fn_ = convert_frame_s16;
+      s16_passthrough_ = true;
+      break;
+    default:
+      throw std::runtime_error("Unsupported filter output sample format");
+    }
   }
 
   void open_output() {
-    // Open output file for writing WAV
-    FILE *f = fopen(output_file_.c_str(), "wb");
-    if (!f) {
+    // Deliberately not libavformat's wav muxer: the S16-pinned sink
+    // already routes the float conversion through swresample's SIMD,
+    // so the muxer would only replace the 44-byte header and the
+    // write loop below -- and the raw fd is what lets finalize patch
+    // the header with pwrite instead of a seek in the stream.
+    //
+    // Open output file for writing WAV; a raw fd instead of stdio so
+    // the header patch in finalize_output can pwrite offset 0 without
+    // flushing or repositioning the sequential payload stream
+    out_fd_ = ::open(output_file_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd_ < 0) {
       throw std::runtime_error(
           std::format("Failed to open output file: {}", output_file_));
     }
-    output_file_handle_ = f;
 
-    // Write WAV header placeholder (will update later)
-    write_wav_header(0);
+    // 1 MiB userspace accumulation buffer so the payload reaches the
+    // kernel in large sequential writes
+    io_buf_.reserve(1 << 20);
+
+    // Write WAV header placeholder (patched in place later)
+    const auto header = build_wav_header(0);
+    write_all(header.data(), header.size());
+
+    // Pre-delay as leading silence, replacing the adelay node the
+    // graph used to carry (adelay with all=1 shifted every channel by
+    // the same constant, which is exactly this padding)
+    if (params_.pre_delay > 0.0) {
+      const size_t predelay_samples =
+          static_cast<size_t>(params_.pre_delay * sample_rate_ / 1000.0) *
+          ch_layout_.nb_channels;
+      const std::vector<int16_t> silence(predelay_samples, 0);
+      write_all(silence.data(), predelay_samples * sizeof(int16_t));
+      total_samples_written_ += static_cast<uint32_t>(predelay_samples);
+    }
   }
 
-  void write_wav_header(const uint32_t data_size) {
-    fseek(output_file_handle_, 0, SEEK_SET);
+  static constexpr size_t kWavHeaderSize = 44;
 
+  std::array<uint8_t, kWavHeaderSize>
+  build_wav_header(const uint32_t data_size) const {
     const int channels = ch_layout_.nb_channels;
     const int bits_per_sample = 16;
-    const int byte_rate = sample_rate_ * channels * bits_per_sample / 8;
-    const int block_align = channels * bits_per_sample / 8;
-
-    // RIFF header
-    fwrite("RIFF", 1, 4, output_file_handle_);
-    const uint32_t chunk_size = 36 + data_size;
-    fwrite(&chunk_size, 4, 1, output_file_handle_);
-    fwrite("WAVE", 1, 4, output_file_handle_);
-
-    // fmt subchunk
-    fwrite("fmt ", 1, 4, output_file_handle_);
-    const uint32_t subchunk1_size = 16;
-    fwrite(&subchunk1_size, 4, 1, output_file_handle_);
-    const uint16_t audio_format = 1; // PCM
-    fwrite(&audio_format, 2, 1, output_file_handle_);
-    const uint16_t num_channels = channels;
-    fwrite(&num_channels, 2, 1, output_file_handle_);
-    fwrite(&sample_rate_, 4, 1, output_file_handle_);
-    fwrite(&byte_rate, 4, 1, output_file_handle_);
-    const uint16_t block_align_val = block_align;
-    fwrite(&block_align_val, 2, 1, output_file_handle_);
-    const uint16_t bits_per_sample_val = bits_per_sample;
-    fwrite(&bits_per_sample_val, 2, 1, output_file_handle_);
-
-    // data subchunk
-    fwrite("data", 1, 4, output_file_handle_);
-    fwrite(&data_size, 4, 1, output_file_handle_);
+    const uint32_t byte_rate = sample_rate_ * channels * bits_per_sample / 8;
+
+    std::array<uint8_t, kWavHeaderSize> header;
+    uint8_t *p = header.data();
+    // Explicit little-endian byte serialization keeps the header
+    // correct regardless of host endianness
+    const auto put_tag = [&p](const char *tag) {
+      std::memcpy(p, tag, 4);
+      p += 4;
+    };
+    const auto put_u16 = [&p](const uint16_t v) {
+      *p++ = static_cast<uint8_t>(v);
+      *p++ = static_cast<uint8_t>(v >> 8);
+    };
+    const auto put_u32 = [&p](const uint32_t v) {
+      *p++ = static_cast<uint8_t>(v);
+      *p++ = static_cast<uint8_t>(v >> 8);
+      *p++ = static_cast<uint8_t>(v >> 16);
+      *p++ = static_cast<uint8_t>(v >> 24);
+    };
+
+    put_tag("RIFF");
+    put_u32(36 + data_size);
+    put_tag("WAVE");
+    put_tag("fmt ");
+    put_u32(16); // fmt subchunk size
+    put_u16(1);  // PCM
+    put_u16(static_cast<uint16_t>(channels));
+    put_u32(static_cast<uint32_t>(sample_rate_));
+    put_u32(byte_rate);
+    put_u16(static_cast<uint16_t>(channels * bits_per_sample / 8));
+    put_u16(static_cast<uint16_t>(bits_per_sample));
+    put_tag("data");
+    put_u32(data_size);
+    return header;
+  }
+
+  // Append to the accumulation buffer, flushing in 1 MiB slabs
+  void write_all(const void *data, const size_t size) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    io_buf_.insert(io_buf_.end(), bytes, bytes + size);
+    if (io_buf_.size() >= (1 << 20)) {
+      flush_io_buf();
+    }
+  }
+
+  void flush_io_buf() {
+    const uint8_t *p = io_buf_.data();
+    size_t left = io_buf_.size();
+    while (left > 0) {
+      const ssize_t n = ::write(out_fd_, p, left);
+      if (n < 0) {
+        throw std::runtime_error(
+            std::format("Failed to write output file: {}", output_file_));
+      }
+      p += n;
+      left -= static_cast<size_t>(n);
+    }
+
+    // The payload is write-once: every 16 MiB, drop what the kernel
+    // has already cleaned from the page cache so a long cathedral
+    // render doesn't evict pages someone else is using. Clean-only
+    // and advisory, so no data is lost if writeback hasn't caught up.
+    bytes_since_advise_ += io_buf_.size();
+    if (bytes_since_advise_ >= (16u << 20)) {
+      posix_fadvise(out_fd_, 0, 0, POSIX_FADV_DONTNEED);
+      bytes_since_advise_ = 0;
+    }
+
+    io_buf_.clear();
   }
 
   void process_audio() {
@@ -324,103 +860,138 @@ private:
       throw std::runtime_error("Failed to allocate frame/packet");
     }
 
-    AVPtr<AVFrame> frame(raw_frame);
-    AVPtr<AVFrame> filt_frame(raw_filt_frame);
-    AVPtr<AVPacket> packet(raw_packet);
-
-    // Read and process packets
-    while (av_read_frame(fmt_ctx_.get(), packet.get()) >= 0) {
-      if (packet->stream_index == audio_stream_idx_) {
-        check_error(avcodec_send_packet(dec_ctx_.get(), packet.get()),
-                    "Sending packet to decoder");
-
-        while (avcodec_receive_frame(dec_ctx_.get(), frame.get()) >= 0) {
-          // Push frame to filter
-          check_error(
-              av_buffersrc_add_frame_flags(buffersrc_ctx_, frame.get(), 0),
-              "Adding frame to buffer source");
-
-          // Pull filtered frames
-          while (av_buffersink_get_frame(buffersink_ctx_, filt_frame.get()) >=
-                 0) {
-            write_audio_frame(filt_frame.get());
-            av_frame_unref(filt_frame.get());
+    FramePtr frame(raw_frame);
+    FramePtr filt_frame(raw_filt_frame);
+    PacketPtr packet(raw_packet);
+
+    // Writer thread: converts and writes frames while this thread
+    // keeps decoding and filtering, so disk stalls no longer block
+    // the decoder (and vice versa)
+    std::thread writer([this] {
+      while (AVFrame *f = write_queue_.pop()) {
+        write_audio_frame(f);
+        frame_pool_.release(f);
+      }
+    });
+
+    try {
+      // Read and process packets
+      while (av_read_frame(fmt_ctx_.get(), packet.get()) >= 0) {
+        if (packet->stream_index == audio_stream_idx_) {
+          check_error(avcodec_send_packet(dec_ctx_.get(), packet.get()),
+                      "Sending packet to decoder");
+
+          while (avcodec_receive_frame(dec_ctx_.get(), frame.get()) >= 0) {
+            // Push frame to filter
+            check_error(
+                av_buffersrc_add_frame_flags(buffersrc_ctx_, frame.get(), 0),
+                "Adding frame to buffer source");
+
+            // Pull filtered frames
+            while (av_buffersink_get_frame(buffersink_ctx_, filt_frame.get()) >=
+                   0) {
+              enqueue_filtered(filt_frame.get());
+            }
+
+            av_frame_unref(frame.get());
           }
-
-          av_frame_unref(frame.get());
         }
+        av_packet_unref(packet.get());
       }
-      av_packet_unref(packet.get());
-    }
 
-    // Flush decoder
-    check_error(avcodec_send_packet(dec_ctx_.get(), nullptr),
-                "Flushing decoder");
-    while (avcodec_receive_frame(dec_ctx_.get(), frame.get()) >= 0) {
-      check_error(av_buffersrc_add_frame_flags(buffersrc_ctx_, frame.get(), 0),
-                  "Adding frame to buffer source");
+      // Flush decoder
+      check_error(avcodec_send_packet(dec_ctx_.get(), nullptr),
+                  "Flushing decoder");
+      while (avcodec_receive_frame(dec_ctx_.get(), frame.get()) >= 0) {
+        check_error(
+            av_buffersrc_add_frame_flags(buffersrc_ctx_, frame.get(), 0),
+            "Adding frame to buffer source");
+
+        while (av_buffersink_get_frame(buffersink_ctx_, filt_frame.get()) >=
+               0) {
+          enqueue_filtered(filt_frame.get());
+        }
 
-      while (av_buffersink_get_frame(buffersink_ctx_, filt_frame.get()) >= 0) {
-        write_audio_frame(filt_frame.get());
-        av_frame_unref(filt_frame.get());
+        av_frame_unref(frame.get());
       }
 
-      av_frame_unref(frame.get());
+      // Flush filter
+      check_error(av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0),
+                  "Flushing filter");
+      while (av_buffersink_get_frame(buffersink_ctx_, filt_frame.get()) >= 0) {
+        enqueue_filtered(filt_frame.get());
+      }
+    } catch (...) {
+      // Let the writer drain what it has so the join below returns
+      write_queue_.finish();
+      writer.join();
+      throw;
     }
 
-    // Flush filter
-    check_error(av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0),
-                "Flushing filter");
-    while (av_buffersink_get_frame(buffersink_ctx_, filt_frame.get()) >= 0) {
-      write_audio_frame(filt_frame.get());
-      av_frame_unref(filt_frame.get());
+    write_queue_.finish();
+    writer.join();
+  }
+
+  // Hand a filtered frame to the writer thread; the queue owns the
+  // heap frame until the writer frees it
+  void enqueue_filtered(AVFrame *filt_frame) {
+    AVFrame *f = frame_pool_.acquire();
+    if (!f) {
+      av_frame_unref(filt_frame);
+      throw std::runtime_error("Failed to allocate frame for writer");
     }
+    av_frame_move_ref(f, filt_frame);
+    write_queue_.push(f);
   }
 
   void write_audio_frame(AVFrame *frame) {
     const int channels = ch_layout_.nb_channels;
     const int samples = frame->nb_samples;
+    const size_t count = static_cast<size_t>(samples) * channels;
+
+    // Packed S16 from the sink is already the file's wire format;
+    // feed it to the output buffer straight from the frame instead of
+    // staging it through conv_buf_
+    if (s16_passthrough_) {
+      write_all(frame->data[0], count * sizeof(int16_t));
+      total_samples_written_ += static_cast<uint32_t>(count);
+      return;
+    }
 
-    // Convert to 16-bit PCM
-    for (int i = 0; i < samples; ++i) {
-      for (int ch = 0; ch < channels; ++ch) {
-        float sample = 0.0f;
-
-        if (frame->format == AV_SAMPLE_FMT_FLTP) {
-          sample = reinterpret_cast<float *>(frame->data[ch])[i];
-        } else if (frame->format == AV_SAMPLE_FMT_FLT) {
-          sample = reinterpret_cast<float *>(frame->data[0])[i * channels + ch];
-        } else if (frame->format == AV_SAMPLE_FMT_S16P) {
-          sample = reinterpret_cast<int16_t *>(frame->data[ch])[i] / 32768.0f;
-        } else if (frame->format == AV_SAMPLE_FMT_S16) {
-          sample =
-              reinterpret_cast<int16_t *>(frame->data[0])[i * channels + ch] /
-              32768.0f;
-        }
+    conv_buf_.resize(count);
+    int16_t *dst = conv_buf_.data();
 
-        // Clamp and convert to 16-bit
-        sample = std::clamp(sample, -1.0f, 1.0f);
-        const auto sample_s16 = static_cast<int16_t>(sample * 32767.0f);
-        fwrite(&sample_s16, sizeof(int16_t), 1, output_file_handle_);
-        total_samples_written_++;
-      }
-    }
+    // convert_fn_ was resolved once after graph configuration, so the
+    // conversion runs without a format check in the loop
+    convert_fn_(frame, dst, samples, channels);
+
+    write_all(dst, count * sizeof(int16_t));
+    total_samples_written_ += static_cast<uint32_t>(count);
   }
 
   void finalize_output() {
+    flush_io_buf();
+
+    // Patch the header in place without disturbing the file offset
     const uint32_t data_size = total_samples_written_ * sizeof(int16_t);
-    write_wav_header(data_size);
-    fclose(output_file_handle_);
-    output_file_handle_ = nullptr;
+    const auto header = build_wav_header(data_size);
+    if (::pwrite(out_fd_, header.data(), header.size(), 0) !=
+        static_cast<ssize_t>(header.size())) {
+      throw std::runtime_error(
+          std::format("Failed to patch WAV header: {}", output_file_));
+    }
+
+    ::close(out_fd_);
+    out_fd_ = -1;
   }
 
   std::string input_file_;
   std::string output_file_;
   ReverbParams params_;
 
-  AVPtr<AVFormatContext> fmt_ctx_;
-  AVPtr<AVCodecContext> dec_ctx_;
-  AVPtr<AVFilterGraph> filter_graph_;
+  FormatCtxPtr fmt_ctx_;
+  CodecCtxPtr dec_ctx_;
+  FilterGraphPtr filter_graph_;
 
   AVFilterContext *buffersrc_ctx_ = nullptr;
   AVFilterContext *buffersink_ctx_ = nullptr;
@@ -430,8 +1001,15 @@ private:
   AVChannelLayout ch_layout_ = AV_CHANNEL_LAYOUT_STEREO;
   AVSampleFormat sample_fmt_ = AV_SAMPLE_FMT_FLTP;
 
-  FILE *output_file_handle_ = nullptr;
+  int out_fd_ = -1;
+  size_t bytes_since_advise_ = 0;
   uint32_t total_samples_written_ = 0;
+  convert_fn convert_fn_ = nullptr;
+  bool s16_passthrough_ = false;
+  FrameRing write_queue_;
+  FramePool frame_pool_;
+  std::vector<int16_t> conv_buf_;
+  std::vector<uint8_t> io_buf_;
 };
 
 void print_usage(const char *program_name) {
@@ -497,52 +1075,23 @@ int main(int argc, char *argv[]) {
 
     // Parse arguments
     for (int i = 3; i < argc; ++i) {
-      const std::string arg = argv[i];
+      const std::string_view arg = argv[i];
 
       if (arg == "--preset" && i + 1 < argc) {
-        const std::string preset = argv[++i];
-        if (preset == "room") {
-          params = PRESET_ROOM;
-        } else if (preset == "hall") {
-          params = PRESET_HALL;
-        } else if (preset == "plate") {
-          params = PRESET_PLATE;
-        } else if (preset == "spring") {
-          params = PRESET_SPRING;
-        } else if (preset == "cathedral") {
-          params = PRESET_CATHEDRAL;
-        } else if (preset == "chamber") {
-          params = PRESET_CHAMBER;
-        } else {
+        const std::string_view preset = argv[++i];
+        const auto it = table_find(kPresetTable, preset);
+        if (it == kPresetTable.end()) {
           throw std::runtime_error(std::format("Unknown preset: {}", preset));
         }
-      } else if (arg == "--room-size" && i + 1 < argc) {
-        params.room_size = std::stod(argv[++i]);
-        if (params.room_size < 0.0 || params.room_size > 1.0) {
-          throw std::runtime_error("Room size must be between 0.0 and 1.0");
-        }
-      } else if (arg == "--reverberance" && i + 1 < argc) {
-        params.reverberance = std::stod(argv[++i]);
-        if (params.reverberance < 0.0 || params.reverberance > 1.0) {
-          throw std::runtime_error("Reverberance must be between 0.0 and 1.0");
-        }
-      } else if (arg == "--hf-damping" && i + 1 < argc) {
-        params.hf_damping = std::stod(argv[++i]);
-        if (params.hf_damping < 0.0 || params.hf_damping > 1.0) {
-          throw std::runtime_error("HF damping must be between 0.0 and 1.0");
-        }
-      } else if (arg == "--wet-gain" && i + 1 < argc) {
-        params.wet_gain = std::stod(argv[++i]);
-      } else if (arg == "--dry-gain" && i + 1 < argc) {
-        params.dry_gain = std::stod(argv[++i]);
-      } else if (arg == "--pre-delay" && i + 1 < argc) {
-        params.pre_delay = std::stod(argv[++i]);
-      } else if (arg == "--stereo-depth" && i + 1 < argc) {
-        params.stereo_depth = std::stod(argv[++i]);
-        if (params.stereo_depth < 0.0 || params.stereo_depth > 100.0) {
-          throw std::runtime_error(
-              "Stereo depth must be between 0.0 and 100.0");
+        params = it->params;
+      } else if (const auto it = table_find(kOptionTable, arg);
+                 it != kOptionTable.end() && i + 1 < argc) {
+        const double value = std::stod(argv[++i]);
+        if (it->lo <= it->hi && (value < it->lo || value > it->hi)) {
+          throw std::runtime_error(std::format("{} must be between {} and {}",
+                                               it->name, it->lo, it->hi));
         }
+        params.*it->field = value;
       }
     }
 
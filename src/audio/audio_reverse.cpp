@@ -14,24 +14,190 @@
 #include "ffmpeg_wrappers.hpp"
 
 #include <iostream>
-#include <fstream>
 #include <format>
 #include <string>
 #include <string_view>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 
 extern "C" {
 #include <libavfilter/buffersink.h>
 #include <libavfilter/buffersrc.h>
+#include <libavutil/cpu.h>
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 namespace fs = std::filesystem;
 
 namespace {
 
+// Reversal kernels. Reversing is pure memory traffic -- two reads and
+// two writes per sample pair -- so the win from SIMD is issuing it 16
+// samples at a time from both ends of the range. Mono swaps
+// individual samples; stereo swaps 32-bit L/R frames so channel
+// order inside each frame is preserved. Variant picked once at load
+// via av_get_cpu_flags(), as the other samples do.
+//
+// Each kernel swaps n units walking front forward and back backward
+// (back points one past the mirrored region), so a full reversal is
+// one call with n = total/2 -- and disjoint sub-ranges of the pair
+// index space can run on different threads.
+using rev_fn = void (*)(int16_t* front, int16_t* back, size_t n);
+
+void reverse_mono_scalar(int16_t* front, int16_t* back, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        --back;
+        std::swap(*front, *back);
+        ++front;
+    }
+}
+
+// A stereo frame is exactly one 32-bit unit, so swap it whole: half
+// the loads/stores of per-channel swaps. memcpy keeps the punning
+// well-defined and folds to single 32-bit moves at -O2.
+void reverse_stereo_scalar(int16_t* front, int16_t* back, size_t n_frames) {
+    for (size_t i = 0; i < n_frames; ++i) {
+        back -= 2;
+        uint32_t f;
+        uint32_t b;
+        std::memcpy(&f, front, sizeof(f));
+        std::memcpy(&b, back, sizeof(b));
+        std::memcpy(front, &b, sizeof(b));
+        std::memcpy(back, &f, sizeof(f));
+        front += 2;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Reverse the 16 int16 lanes of a vector: byte-shuffle within each
+// 128-bit lane, then swap the lanes
+__attribute__((target("avx2"))) inline __m256i reverse16_s16(__m256i v) {
+    const __m256i mask = _mm256_setr_epi8(
+        14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+        14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+    v = _mm256_shuffle_epi8(v, mask);
+    return _mm256_permute2x128_si256(v, v, 1);
+}
+
+__attribute__((target("avx2"))) void reverse_mono_avx2(int16_t* front, int16_t* back, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        back -= 16;
+        // The descending stream runs against the hardware prefetcher's
+        // grain, so fetch both streams four vectors (two lines) ahead
+        _mm_prefetch(reinterpret_cast<const char*>(front + 64), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(back - 64), _MM_HINT_T0);
+        const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(front));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(back));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(front), reverse16_s16(b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(back), reverse16_s16(f));
+        front += 16;
+    }
+    reverse_mono_scalar(front, back, n - i);
+}
+
+__attribute__((target("avx2"))) void reverse_stereo_avx2(int16_t* front, int16_t* back, size_t n_frames) {
+    // One cross-lane permute reverses eight 32-bit L/R frames
+    const __m256i idx = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    size_t i = 0;
+    for (; i + 8 <= n_frames; i += 8) {
+        back -= 16;
+        // Same software prefetch as the mono kernel: the backward
+        // stream gets no help from the hardware prefetcher
+        _mm_prefetch(reinterpret_cast<const char*>(front + 64), _MM_HINT_T0);
+        _mm_prefetch(reinterpret_cast<const char*>(back - 64), _MM_HINT_T0);
+        const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(front));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(back));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(front),
+                            _mm256_permutevar8x32_epi32(b, idx));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(back),
+                            _mm256_permutevar8x32_epi32(f, idx));
+        front += 16;
+    }
+    reverse_stereo_scalar(front, back, n_frames - i);
+}
+
+#elif defined(__ARM_NEON)
+
+// Reverse the 8 int16 lanes: reverse within each 64-bit half, then
+// swap the halves
+inline int16x8_t reverse8_s16(int16x8_t v) {
+    v = vrev64q_s16(v);
+    return vextq_s16(v, v, 4);
+}
+
+void reverse_mono_neon(int16_t* front, int16_t* back, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        back -= 8;
+        const int16x8_t f = vld1q_s16(front);
+        const int16x8_t b = vld1q_s16(back);
+        vst1q_s16(front, reverse8_s16(b));
+        vst1q_s16(back, reverse8_s16(f));
+        front += 8;
+    }
+    reverse_mono_scalar(front, back, n - i);
+}
+
+void reverse_stereo_neon(int16_t* front, int16_t* back, size_t n_frames) {
+    size_t i = 0;
+    for (; i + 4 <= n_frames; i += 4) {
+        back -= 8;
+        int16x8_t f = vld1q_s16(front);
+        int16x8_t b = vld1q_s16(back);
+        // Reverse as 32-bit frames: swap within halves, then halves
+        f = vreinterpretq_s16_u32(vrev64q_u32(vreinterpretq_u32_s16(f)));
+        b = vreinterpretq_s16_u32(vrev64q_u32(vreinterpretq_u32_s16(b)));
+        vst1q_s16(front, vextq_s16(b, b, 4));
+        vst1q_s16(back, vextq_s16(f, f, 4));
+        front += 8;
+    }
+    reverse_stereo_scalar(front, back, n_frames - i);
+}
+
+#endif
+
+rev_fn select_reverse_mono() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+        return reverse_mono_avx2;
+    }
+#elif defined(__ARM_NEON)
+    return reverse_mono_neon;
+#endif
+    return reverse_mono_scalar;
+}
+
+rev_fn select_reverse_stereo() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+        return reverse_stereo_avx2;
+    }
+#elif defined(__ARM_NEON)
+    return reverse_stereo_neon;
+#endif
+    return reverse_stereo_scalar;
+}
+
+const rev_fn reverse_mono = select_reverse_mono();
+const rev_fn reverse_stereo = select_reverse_stereo();
+
 // WAV header structure
 struct WAVHeader {
     char riff_header[4] = {'R', 'I', 'F', 'F'};
@@ -49,7 +215,7 @@ struct WAVHeader {
     uint32_t data_bytes;
 };
 
-void write_wav_header(std::ofstream& file, int sample_rate, int channels, uint32_t data_size) {
+WAVHeader build_wav_header(int sample_rate, int channels, uint32_t data_size) {
     WAVHeader header;
     header.num_channels = static_cast<uint16_t>(channels);
     header.sample_rate = static_cast<uint32_t>(sample_rate);
@@ -58,10 +224,109 @@ void write_wav_header(std::ofstream& file, int sample_rate, int channels, uint32
     header.block_align = static_cast<uint16_t>(channels * 2);
     header.data_bytes = data_size;
     header.wav_size = 36 + data_size;
+    return header;
+}
 
-    file.write(reinterpret_cast<const char*>(&header), sizeof(WAVHeader));
+// ::write with the short-write loop POSIX requires
+void write_full(int fd, const void* data, size_t size) {
+    const auto* p = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = ::write(fd, p, size);
+        if (n < 0) {
+            throw std::runtime_error("Failed to write output file");
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
 }
 
+// Growable sample store backed by a memfd mapping instead of an
+// anonymous heap vector. Growth is ftruncate + remap -- the kernel
+// keeps the pages, so unlike vector reallocation nothing is copied --
+// and under memory pressure the pages are individually evictable to
+// swap rather than pinning peak RSS for the whole take. Interface is
+// the subset of std::vector the reverser actually uses.
+class MappedSampleBuffer {
+public:
+    MappedSampleBuffer() = default;
+
+    MappedSampleBuffer(const MappedSampleBuffer&) = delete;
+    MappedSampleBuffer& operator=(const MappedSampleBuffer&) = delete;
+
+    ~MappedSampleBuffer() {
+        if (map_) {
+            munmap(map_, cap_bytes_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int16_t* data() { return map_; }
+    const int16_t* data() const { return map_; }
+    size_t size() const { return size_; }
+
+    // Re-hint the kernel once the access pattern changes phase
+    void advise(int advice) {
+        if (map_) {
+            posix_madvise(map_, cap_bytes_, advice);
+        }
+    }
+
+    void reserve(size_t n) {
+        if (n > cap_) {
+            grow(n);
+        }
+    }
+
+    void resize(size_t n) {
+        if (n > cap_) {
+            grow(std::max(n, cap_ * 2));
+        }
+        size_ = n;
+    }
+
+private:
+    void grow(size_t new_cap) {
+        if (fd_ < 0) {
+            fd_ = memfd_create("audio-reverse-samples", 0);
+            if (fd_ < 0) {
+                throw std::runtime_error("Failed to create sample buffer memfd");
+            }
+        }
+
+        // Page-align and never shrink below the initial megabyte
+        constexpr size_t kMinElems = (1 << 20) / sizeof(int16_t);
+        new_cap = std::max(new_cap, kMinElems);
+        const size_t bytes =
+            (new_cap * sizeof(int16_t) + 4095) & ~static_cast<size_t>(4095);
+
+        if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            throw std::runtime_error("Failed to grow sample buffer");
+        }
+
+        if (map_) {
+            munmap(map_, cap_bytes_);
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error("Failed to map sample buffer");
+        }
+        // The append phase walks the mapping linearly
+        posix_madvise(p, bytes, POSIX_MADV_SEQUENTIAL);
+
+        map_ = static_cast<int16_t*>(p);
+        cap_ = bytes / sizeof(int16_t);
+        cap_bytes_ = bytes;
+    }
+
+    int fd_ = -1;
+    int16_t* map_ = nullptr;
+    size_t size_ = 0;
+    size_t cap_ = 0;
+    size_t cap_bytes_ = 0;
+};
+
 struct ReverseParams {
     double start_time = 0.0;        // Start time in seconds (0 = beginning)
     double end_time = -1.0;         // End time in seconds (-1 = end of file)
@@ -90,27 +355,47 @@ public:
         std::cout << "Reading audio...\n";
         read_all_samples();
 
-        // Calculate reverse range
-        int64_t start_sample = static_cast<int64_t>(params_.start_time * sample_rate_);
-        int64_t end_sample = params_.end_time < 0 ?
-                            total_samples_ :
-                            static_cast<int64_t>(params_.end_time * sample_rate_);
-
-        // Clamp to valid range
-        start_sample = std::clamp(start_sample, int64_t{0}, total_samples_);
-        end_sample = std::clamp(end_sample, start_sample, total_samples_);
+        // Calculate reverse range: whole-file mode pins both ends
+        // directly, range mode rounds and clamps in one expression
+        // per bound (min/max lower to cmov, no branching)
+        const int64_t start_sample =
+            params_.reverse_all
+                ? 0
+                : std::clamp<int64_t>(llround(params_.start_time * sample_rate_),
+                                      0, total_samples_);
+        const int64_t end_sample =
+            params_.reverse_all || params_.end_time < 0
+                ? total_samples_
+                : std::clamp<int64_t>(llround(params_.end_time * sample_rate_),
+                                      start_sample, total_samples_);
 
         std::cout << std::format("Reversing samples {} to {} ({:.2f}s to {:.2f}s)\n",
                                 start_sample, end_sample,
                                 start_sample / static_cast<double>(sample_rate_),
                                 end_sample / static_cast<double>(sample_rate_));
 
-        // Reverse the specified range
-        reverse_samples(start_sample, end_sample);
+        // Ingest is over; the reverse/write phase walks the mapping
+        // backwards (or from both ends), which linear readahead only
+        // pollutes, so drop the sequential hint set during append
+        all_samples_.advise(POSIX_MADV_RANDOM);
 
-        // Write output
-        std::cout << "Writing output...\n";
-        write_output();
+        if (params_.reverse_all) {
+            // Whole-file reversal fuses with the output pass: blocks
+            // are read from the tail of the buffer, reversed into a
+            // scratch chunk and written -- one streaming sweep instead
+            // of an in-place reverse followed by a full write
+            std::cout << "Writing output (reversed)...\n";
+            write_output_reversed();
+        } else {
+            // Reverse only the specified range; the bounds above are
+            // already clamped to valid sample indices
+            reverse_sample_range(static_cast<size_t>(start_sample) * channels_,
+                                 static_cast<size_t>(end_sample) * channels_);
+
+            // Write output
+            std::cout << "Writing output...\n";
+            write_output();
+        }
 
         std::cout << std::format("\nReverse completed!\n");
         std::cout << std::format("Duration: {:.2f} seconds\n",
@@ -120,6 +405,20 @@ public:
 
 private:
     void initialize() {
+        // Prime the page cache before decode starts: libavio has the
+        // file open but doesn't expose its fd, so hint through a
+        // throwaway one. WILLNEED kicks off readahead into the page
+        // cache, which the decoder's reads then hit; SEQUENTIAL/
+        // NOREUSE widen readahead and mark the pages drop-after-use
+        // on kernels that honour them per-file. Best effort -- a
+        // failed hint just means cold-cache throughput.
+        if (const int fd = ::open(input_file_.c_str(), O_RDONLY); fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            ::close(fd);
+        }
+
         // Find audio stream
         const auto stream_idx = ffmpeg::find_stream_index(format_ctx_.get(),
                                                          AVMEDIA_TYPE_AUDIO);
@@ -128,6 +427,16 @@ private:
         }
         audio_stream_index_ = *stream_idx;
 
+        // Tell the demuxer to drop every other stream at the source:
+        // video/subtitle packets of a muxed input then never get
+        // read, allocated or pushed through the loop just to be
+        // discarded by the stream-index check
+        for (unsigned i = 0; i < format_ctx_->nb_streams; ++i) {
+            if (static_cast<int>(i) != audio_stream_index_) {
+                format_ctx_->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
         // Setup decoder
         const auto* codecpar = format_ctx_->streams[audio_stream_index_]->codecpar;
         const auto* decoder = avcodec_find_decoder(codecpar->codec_id);
@@ -140,6 +449,13 @@ private:
             avcodec_parameters_to_context(decoder_ctx_.get(), codecpar),
             "copy codec parameters"
         );
+        // Let the codec decode on all cores where it can: frame
+        // threading pipelines whole frames across workers, slice
+        // threading splits within one. Decoders that support neither
+        // ignore the hint, so this is free for simple PCM inputs.
+        decoder_ctx_->thread_count = 0;  // auto-detect core count
+        decoder_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
         ffmpeg::check_error(
             avcodec_open2(decoder_ctx_.get(), decoder, nullptr),
             "open decoder"
@@ -158,6 +474,18 @@ private:
     }
 
     void setup_resampler() {
+        // Inputs already decoded as 16-bit mono/stereo need no
+        // resampler at all -- packed S16 is the storage format, so a
+        // straight copy (or an interleave for planar) saves a full
+        // converter pass over every sample
+        const auto fmt = decoder_ctx_->sample_fmt;
+        if ((fmt == AV_SAMPLE_FMT_S16 || fmt == AV_SAMPLE_FMT_S16P) &&
+            (channels_ == 1 || channels_ == 2)) {
+            passthrough_ = true;
+            planar_passthrough_ = fmt == AV_SAMPLE_FMT_S16P && channels_ == 2;
+            return;
+        }
+
         AVChannelLayout out_ch_layout;
         if (channels_ == 1) {
             out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
@@ -186,10 +514,67 @@ private:
         );
     }
 
+    // Append an already-S16 frame without touching swresample
+    void ingest_passthrough() {
+        const int nb_samples = frame_->nb_samples;
+        const size_t count = static_cast<size_t>(nb_samples) * channels_;
+        const size_t old_size = all_samples_.size();
+        all_samples_.resize(old_size + count);
+        int16_t* dst = all_samples_.data() + old_size;
+
+        if (planar_passthrough_) {
+            const auto* l = reinterpret_cast<const int16_t*>(frame_->data[0]);
+            const auto* r = reinterpret_cast<const int16_t*>(frame_->data[1]);
+            for (int i = 0; i < nb_samples; ++i) {
+                dst[2 * i] = l[i];
+                dst[2 * i + 1] = r[i];
+            }
+        } else {
+            std::memcpy(dst, frame_->data[0], count * sizeof(int16_t));
+        }
+        total_samples_ += nb_samples;
+    }
+
+    // Interactive-only, wall-clock throttled progress line: the \r
+    // overwrite is noise in redirected logs, and every flush is a
+    // write syscall the decode loop doesn't need. 200ms is faster
+    // than anyone reads and slower than any frame arrives.
+    void maybe_print_progress() {
+        static const bool is_tty = isatty(fileno(stdout)) != 0;
+        if (!is_tty) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_progress_ < std::chrono::milliseconds(200)) {
+            return;
+        }
+        last_progress_ = now;
+        // Stack-format and write(2) directly: no heap string, no
+        // stream lock, and nothing ahead of the line to flush
+        char buf[64];
+        const auto res = std::format_to_n(
+            buf, sizeof(buf), "Read: {:.2f}s\r",
+            total_samples_ / static_cast<double>(sample_rate_));
+        [[maybe_unused]] const ssize_t n =
+            ::write(STDOUT_FILENO, buf, static_cast<size_t>(res.size));
+    }
+
     void read_all_samples() {
-        int iteration = 0;
+        // Reserve the whole take up front when the container knows its
+        // duration, so ingest doesn't pay repeated reallocation copies
+        if (format_ctx_->duration != AV_NOPTS_VALUE) {
+            const auto expected_samples = static_cast<size_t>(
+                format_ctx_->duration / static_cast<double>(AV_TIME_BASE) *
+                sample_rate_);
+            all_samples_.reserve((expected_samples + sample_rate_) * channels_);
+        }
 
         while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
+            // Exception-safe single unref, matching the pattern the
+            // other tools use -- check_error throws below, and a
+            // leaked ref would stall refcounted decoders
+            ffmpeg::ScopedPacketUnref packet_guard(packet_.get());
+
             if (packet_->stream_index == audio_stream_index_) {
                 ffmpeg::check_error(
                     avcodec_send_packet(decoder_ctx_.get(), packet_.get()),
@@ -197,11 +582,24 @@ private:
                 );
 
                 while (avcodec_receive_frame(decoder_ctx_.get(), frame_.get()) >= 0) {
-                    // Resample to S16
+                    if (passthrough_) {
+                        ingest_passthrough();
+                        maybe_print_progress();
+                        continue;
+                    }
+
+                    // Resample straight into the tail of all_samples_:
+                    // grow the vector first, hand swr_convert the new
+                    // region, then trim to what actually converted.
+                    // No staging buffer, no per-sample copies, and --
+                    // with the up-front reserve -- no per-frame heap
+                    // traffic either; the resizes below only move the
+                    // end marker within reserved capacity.
                     const int max_samples = frame_->nb_samples;
-                    std::vector<int16_t> buffer(max_samples * channels_);
+                    const size_t old_size = all_samples_.size();
+                    all_samples_.resize(old_size + static_cast<size_t>(max_samples) * channels_);
 
-                    auto* out_buf = reinterpret_cast<uint8_t*>(buffer.data());
+                    auto* out_buf = reinterpret_cast<uint8_t*>(all_samples_.data() + old_size);
                     const int samples_converted = swr_convert(
                         swr_ctx_.get(),
                         &out_buf,
@@ -211,21 +609,16 @@ private:
                     );
 
                     if (samples_converted > 0) {
-                        // Store samples
-                        for (int i = 0; i < samples_converted * channels_; ++i) {
-                            all_samples_.push_back(buffer[i]);
-                        }
+                        all_samples_.resize(old_size + static_cast<size_t>(samples_converted) * channels_);
                         total_samples_ += samples_converted;
+                    } else {
+                        all_samples_.resize(old_size);
+                        ffmpeg::check_error(samples_converted, "resample frame");
                     }
 
-                    ++iteration;
-                    if (iteration % 100 == 0) {
-                        const auto seconds = total_samples_ / static_cast<double>(sample_rate_);
-                        std::cout << std::format("Read: {:.2f}s\r", seconds) << std::flush;
-                    }
+                    maybe_print_progress();
                 }
             }
-            av_packet_unref(packet_.get());
         }
 
         std::cout << std::format("Read: {:.2f}s (total samples: {})\n",
@@ -233,66 +626,132 @@ private:
                                 total_samples_);
     }
 
-    void reverse_samples(int64_t start_sample, int64_t end_sample) {
-        if (params_.reverse_all) {
-            // Reverse entire audio
-            std::cout << "Reversing entire audio...\n";
-            reverse_sample_range(0, all_samples_.size());
-        } else {
-            // Reverse only specified range
-            const auto start_idx = static_cast<size_t>(start_sample * channels_);
-            const auto end_idx = static_cast<size_t>(end_sample * channels_);
-
-            if (start_idx < all_samples_.size() && end_idx <= all_samples_.size()) {
-                std::cout << std::format("Reversing samples from index {} to {}\n",
-                                        start_idx, end_idx);
-                reverse_sample_range(start_idx, end_idx);
-            } else {
-                std::cerr << "Warning: Invalid range, reversing entire audio\n";
-                reverse_sample_range(0, all_samples_.size());
-            }
-        }
-    }
-
     void reverse_sample_range(size_t start_idx, size_t end_idx) {
         // Reverse in frame units (preserving channel order within each frame)
         const size_t num_frames = (end_idx - start_idx) / channels_;
+        const size_t pairs = num_frames / 2;
+        int16_t* base = all_samples_.data() + start_idx;
+
+        if (channels_ > 2) {
+            // Generic scalar fallback for exotic layouts
+            for (size_t i = 0; i < pairs; ++i) {
+                int16_t* front = base + i * channels_;
+                int16_t* back = base + (num_frames - 1 - i) * channels_;
+                for (int ch = 0; ch < channels_; ++ch) {
+                    std::swap(front[ch], back[ch]);
+                }
+            }
+            std::cout << "Progress: 100%\n";
+            return;
+        }
 
-        for (size_t i = 0; i < num_frames / 2; ++i) {
-            const size_t front_frame_idx = start_idx + i * channels_;
-            const size_t back_frame_idx = start_idx + (num_frames - 1 - i) * channels_;
+        const rev_fn kernel = channels_ == 1 ? reverse_mono : reverse_stereo;
 
-            // Swap entire frames
-            for (int ch = 0; ch < channels_; ++ch) {
-                std::swap(all_samples_[front_frame_idx + ch],
-                         all_samples_[back_frame_idx + ch]);
-            }
+        // The swap pairs are disjoint, so contiguous slices of the
+        // pair index space can run on separate threads; each thread
+        // streams two linear regions, adding memory-channel
+        // parallelism to a bandwidth-bound loop. Short ranges stay
+        // serial -- thread startup would dominate.
+        constexpr size_t kParallelThreshold = size_t{1} << 21; // pairs
+        const unsigned hw = std::thread::hardware_concurrency();
+        const size_t nthreads =
+            std::min<size_t>(hw > 0 ? hw : 1, pairs / kParallelThreshold + 1);
 
-            // Progress indicator
-            if (i % 100000 == 0) {
-                const auto progress = (i * 2 * 100) / num_frames;
-                std::cout << std::format("Progress: {}%\r", progress) << std::flush;
+        if (nthreads <= 1) {
+            kernel(base, base + num_frames * channels_, pairs);
+        } else {
+            std::vector<std::thread> workers;
+            workers.reserve(nthreads);
+            const size_t per_thread = pairs / nthreads;
+            for (size_t t = 0; t < nthreads; ++t) {
+                const size_t lo = t * per_thread;
+                const size_t hi = t + 1 == nthreads ? pairs : lo + per_thread;
+                workers.emplace_back([=, ch = channels_] {
+                    kernel(base + lo * ch,
+                           base + (num_frames - lo) * ch,
+                           hi - lo);
+                });
+            }
+            for (auto& w : workers) {
+                w.join();
             }
         }
         std::cout << "Progress: 100%\n";
     }
 
-    void write_output() {
-        std::ofstream output_stream(output_file_, std::ios::binary);
-        if (!output_stream.is_open()) {
+    // Reverse a block that was copied out of the main buffer; the
+    // main-range kernels do the mono/stereo work, the loop handles
+    // exotic layouts
+    void reverse_block(int16_t* block, size_t n_frames) const {
+        if (channels_ == 1) {
+            reverse_mono(block, block + n_frames, n_frames / 2);
+        } else if (channels_ == 2) {
+            reverse_stereo(block, block + 2 * n_frames, n_frames / 2);
+        } else {
+            for (size_t i = 0; i < n_frames / 2; ++i) {
+                int16_t* front = block + i * channels_;
+                int16_t* back = block + (n_frames - 1 - i) * channels_;
+                for (int ch = 0; ch < channels_; ++ch) {
+                    std::swap(front[ch], back[ch]);
+                }
+            }
+        }
+    }
+
+    // Open the output, size it up front and emit the header; the
+    // payload follows through write_full in large sequential chunks
+    int open_output_fd(uint32_t data_size) const {
+        const int fd = ::open(output_file_.string().c_str(),
+                              O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
             throw std::runtime_error(
                 std::format("Failed to open output file: {}", output_file_.string())
             );
         }
 
-        // Calculate data size
+        // Best-effort hints: reserve the final extent so the
+        // filesystem doesn't grow the file write by write, and
+        // declare the sequential pattern
+        posix_fallocate(fd, 0,
+                        static_cast<off_t>(sizeof(WAVHeader)) + data_size);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        const WAVHeader header = build_wav_header(sample_rate_, channels_, data_size);
+        write_full(fd, &header, sizeof(header));
+        return fd;
+    }
+
+    void write_output_reversed() {
         const uint32_t data_size = static_cast<uint32_t>(all_samples_.size() * sizeof(int16_t));
+        const int fd = open_output_fd(data_size);
+
+        // Walk the buffer back to front in 1 MiB blocks, reversing
+        // each block into scratch before it goes out -- one syscall
+        // per megabyte of payload
+        const size_t total_frames = all_samples_.size() / channels_;
+        const size_t chunk_frames =
+            std::max<size_t>(1, (1 << 20) / (sizeof(int16_t) * channels_));
+        std::vector<int16_t> chunk(chunk_frames * channels_);
+
+        size_t frames_left = total_frames;
+        while (frames_left > 0) {
+            const size_t n = std::min(chunk_frames, frames_left);
+            const int16_t* src = all_samples_.data() + (frames_left - n) * channels_;
+            std::copy_n(src, n * channels_, chunk.data());
+            reverse_block(chunk.data(), n);
+            write_full(fd, chunk.data(), n * channels_ * sizeof(int16_t));
+            frames_left -= n;
+        }
 
-        // Write WAV header
-        write_wav_header(output_stream, sample_rate_, channels_, data_size);
+        ::close(fd);
+        std::cout << std::format("Written {} bytes\n", data_size);
+    }
 
-        // Write audio data
-        output_stream.write(reinterpret_cast<const char*>(all_samples_.data()), data_size);
+    void write_output() {
+        const uint32_t data_size = static_cast<uint32_t>(all_samples_.size() * sizeof(int16_t));
+        const int fd = open_output_fd(data_size);
+        write_full(fd, all_samples_.data(), data_size);
+        ::close(fd);
 
         std::cout << std::format("Written {} bytes\n", data_size);
     }
@@ -333,8 +792,19 @@ private:
     int channels_ = 0;
     double duration_ = 0.0;
 
-    std::vector<int16_t> all_samples_;
+    // Whole take as packed S16, in an evictable memfd mapping (see
+    // MappedSampleBuffer). Deliberately not the two-pass "re-decode
+    // packets back to front" scheme: packets of most compressed
+    // codecs aren't independently decodable (inter-frame prediction,
+    // encoder delay/padding), so a correct backward pass needs
+    // keyframe-accurate seeks plus per-packet re-priming, and buys
+    // nothing over this file-backed buffer for inputs that outgrow
+    // RAM.
+    MappedSampleBuffer all_samples_;
     int64_t total_samples_ = 0;
+    bool passthrough_ = false;
+    std::chrono::steady_clock::time_point last_progress_{};
+    bool planar_passthrough_ = false;
 };
 
 void print_usage(const char* prog_name) {
@@ -19,8 +19,16 @@
 extern "C" {
 #include <libavfilter/buffersink.h>
 #include <libavfilter/buffersrc.h>
+#include <libavutil/cpu.h>
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <cmath>
+#include <cstdlib>
+
 namespace {
 
 struct SilenceSegment {
@@ -88,6 +96,24 @@ std::optional<DetectionParams> parse_arguments(int argc, char* argv[]) {
     return params;
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+// One 16-sample block of the S16 level scan: |x| > threshold
+// condensed to a byte mask. 0 means the whole block is below
+// threshold, all-ones means the whole block is above; anything else
+// falls back to the scalar per-sample walk. Two signed compares
+// rather than abs+cmpgt: abs_epi16 folds INT16_MIN to itself, which
+// would count full-scale negative peaks as silence while the scalar
+// walk (which widens to int before std::abs) counts them loud.
+__attribute__((target("avx2"))) inline uint32_t
+loud_mask16_avx2(const int16_t* x, int16_t threshold) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x));
+    const __m256i hi = _mm256_cmpgt_epi16(v, _mm256_set1_epi16(threshold));
+    const __m256i lo =
+        _mm256_cmpgt_epi16(_mm256_set1_epi16(static_cast<int16_t>(-threshold)), v);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(hi, lo)));
+}
+#endif
+
 class AudioSilenceDetector {
 public:
     AudioSilenceDetector(std::string_view input_file, const DetectionParams& params)
@@ -115,7 +141,65 @@ public:
 
         std::cout << std::format("Processing {:.2f} seconds of audio...\n\n", total_duration);
 
-        // Process audio and collect silence segments
+        if (direct_scan_) {
+            detect_direct();
+        } else {
+            detect_filtered();
+        }
+
+        // Export report if requested
+        if (params_.export_report) {
+            export_report(total_duration);
+        }
+
+        print_summary(total_duration);
+    }
+
+private:
+    // Direct level scan for the formats decoders actually emit. The
+    // silencedetect graph is only built when the sample format is
+    // something this scanner doesn't handle; for S16/S16P/FLT/FLTP
+    // the threshold comparison runs right on the decoded frames and
+    // the segments land in a real vector instead of the log stream.
+    void detect_direct() {
+        int64_t frame_count = 0;
+
+        while (av_read_frame(input_format_ctx_.get(), input_packet_.get()) >= 0) {
+            ffmpeg::ScopedPacketUnref packet_guard(input_packet_.get());
+
+            if (input_packet_->stream_index != audio_stream_index_) {
+                continue;
+            }
+
+            if (avcodec_send_packet(input_codec_ctx_.get(), input_packet_.get()) < 0) {
+                continue;
+            }
+
+            while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >= 0) {
+                ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
+                scan_frame();
+                frame_count++;
+            }
+        }
+
+        // Flush decoder
+        avcodec_send_packet(input_codec_ctx_.get(), nullptr);
+        while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >= 0) {
+            ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
+            scan_frame();
+            frame_count++;
+        }
+
+        // Trailing silence ends with the stream
+        maybe_emit_segment();
+
+        std::cout << std::format("Processed {} frames\n\n", frame_count);
+        print_segments();
+    }
+
+    // Legacy path: run the frames through the silencedetect filter
+    // and point the user at its log output
+    void detect_filtered() {
         int64_t frame_count = 0;
 
         while (av_read_frame(input_format_ctx_.get(), input_packet_.get()) >= 0) {
@@ -132,9 +216,12 @@ public:
             while (avcodec_receive_frame(input_codec_ctx_.get(), input_frame_.get()) >= 0) {
                 ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
 
-                // Push frame to filter
+                // Push frame to filter; flag 0 lets the graph take
+                // the reference instead of cloning it -- nothing here
+                // reads the frame after the push, the guard just
+                // resets it for the next receive
                 if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                                AV_BUFFERSRC_FLAG_KEEP_REF) < 0) {
+                                                0) < 0) {
                     std::cerr << "Error feeding frame to filter\n";
                     break;
                 }
@@ -153,7 +240,7 @@ public:
             ffmpeg::ScopedFrameUnref frame_guard(input_frame_.get());
 
             if (av_buffersrc_add_frame_flags(buffersrc_ctx_, input_frame_.get(),
-                                            AV_BUFFERSRC_FLAG_KEEP_REF) >= 0) {
+                                            0) >= 0) {
                 while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
                     ffmpeg::ScopedFrameUnref filtered_guard(filtered_frame_.get());
                     frame_count++;
@@ -172,16 +259,110 @@ public:
         std::cout << "Detection complete!\n";
         std::cout << "Note: Check FFmpeg output above for silence detection results.\n";
         std::cout << "      Silence segments are logged by the silencedetect filter.\n\n";
+    }
 
-        // Export report if requested
-        if (params_.export_report) {
-            export_report(total_duration);
+    // --- direct-scan machinery -------------------------------------
+
+    // One decoded frame into the run tracker. Units are "scan units":
+    // interleaved samples for packed formats, frames for planar, so
+    // the run threshold and timestamps divide out consistently.
+    void scan_frame() {
+        const AVFrame* f = input_frame_.get();
+        const int nb = f->nb_samples;
+        const int ch = input_codec_ctx_->ch_layout.nb_channels;
+
+        switch (scan_fmt_) {
+        case AV_SAMPLE_FMT_S16:
+            scan_s16(reinterpret_cast<const int16_t*>(f->data[0]),
+                     static_cast<size_t>(nb) * ch);
+            break;
+        case AV_SAMPLE_FMT_S16P:
+            for (int i = 0; i < nb; ++i) {
+                bool loud = false;
+                for (int c = 0; c < ch; ++c) {
+                    const auto v = reinterpret_cast<const int16_t*>(f->data[c])[i];
+                    loud |= std::abs(static_cast<int>(v)) > thr_s16_;
+                }
+                step_unit(loud);
+            }
+            break;
+        case AV_SAMPLE_FMT_FLT:
+            for (size_t i = 0; i < static_cast<size_t>(nb) * ch; ++i) {
+                const float v = reinterpret_cast<const float*>(f->data[0])[i];
+                step_unit(std::fabs(v) > thr_flt_);
+            }
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+        default:
+            for (int i = 0; i < nb; ++i) {
+                bool loud = false;
+                for (int c = 0; c < ch; ++c) {
+                    const float v = reinterpret_cast<const float*>(f->data[c])[i];
+                    loud |= std::fabs(v) > thr_flt_;
+                }
+                step_unit(loud);
+            }
+            break;
         }
+    }
 
-        print_summary(total_duration);
+    // Packed S16: classify 16-sample blocks with one AVX2 compare;
+    // uniform blocks advance the run in a single step, mixed blocks
+    // drop to the scalar walk for exact boundaries
+    void scan_s16(const int16_t* x, size_t n) {
+        size_t i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+        if (use_avx2_) {
+            for (; i + 16 <= n; i += 16) {
+                const uint32_t mask = loud_mask16_avx2(x + i, thr_s16_);
+                if (mask == 0) {
+                    run_ += 16;
+                    pos_ += 16;
+                } else if (mask == 0xFFFFFFFFu) {
+                    maybe_emit_segment();
+                    run_ = 0;
+                    pos_ += 16;
+                } else {
+                    for (size_t j = 0; j < 16; ++j) {
+                        step_unit(std::abs(static_cast<int>(x[i + j])) > thr_s16_);
+                    }
+                }
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            step_unit(std::abs(static_cast<int>(x[i])) > thr_s16_);
+        }
+    }
+
+    void step_unit(const bool loud) {
+        if (loud) {
+            maybe_emit_segment();
+            run_ = 0;
+        } else {
+            ++run_;
+        }
+        ++pos_;
+    }
+
+    void maybe_emit_segment() {
+        if (run_ >= min_run_units_) {
+            const double start = static_cast<double>(pos_ - run_) / units_per_second_;
+            const double end = static_cast<double>(pos_) / units_per_second_;
+            segments_.push_back({start, end, end - start});
+        }
+    }
+
+    void print_segments() const {
+        std::cout << std::format("Detected {} silence segment(s):\n", segments_.size());
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            const auto& seg = segments_[i];
+            std::cout << std::format("  [{:>3}] {:9.3f}s -> {:9.3f}s  ({:.3f}s)\n",
+                                    i + 1, seg.start_time, seg.end_time, seg.duration);
+        }
+        std::cout << "\n";
     }
 
-private:
     void initialize() {
         // Find audio stream
         audio_stream_index_ = av_find_best_stream(
@@ -191,6 +372,14 @@ private:
             throw std::runtime_error("Failed to find audio stream");
         }
 
+        // Discard non-audio streams in the demuxer itself so their
+        // packets never reach the read loop
+        for (unsigned i = 0; i < input_format_ctx_->nb_streams; ++i) {
+            if (static_cast<int>(i) != audio_stream_index_) {
+                input_format_ctx_->streams[i]->discard = AVDISCARD_ALL;
+            }
+        }
+
         const auto* input_stream = input_format_ctx_->streams[audio_stream_index_];
 
         // Setup decoder
@@ -202,12 +391,46 @@ private:
         input_codec_ctx_ = ffmpeg::create_codec_context(decoder);
         avcodec_parameters_to_context(input_codec_ctx_.get(), input_stream->codecpar);
 
+        // Same multi-threaded decode hint as the other tools: frame
+        // and slice threading where the codec supports them, ignored
+        // where it doesn't
+        input_codec_ctx_->thread_count = 0;  // auto-detect core count
+        input_codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
         if (avcodec_open2(input_codec_ctx_.get(), decoder, nullptr) < 0) {
             throw std::runtime_error("Failed to open decoder");
         }
 
-        // Setup filter graph
-        setup_filter_graph();
+        // Prefer the direct scan whenever the decoder output is a
+        // format the scanner understands; the filter graph (and its
+        // per-frame refcount churn) only exists for everything else
+        const auto fmt = input_codec_ctx_->sample_fmt;
+        direct_scan_ = fmt == AV_SAMPLE_FMT_S16 || fmt == AV_SAMPLE_FMT_S16P ||
+                       fmt == AV_SAMPLE_FMT_FLT || fmt == AV_SAMPLE_FMT_FLTP;
+
+        if (direct_scan_) {
+            scan_fmt_ = fmt;
+            const double linear = std::pow(10.0, params_.noise_threshold / 20.0);
+            thr_flt_ = static_cast<float>(linear);
+            thr_s16_ = static_cast<int16_t>(
+                std::min(32767.0, linear * 32768.0));
+
+            // Packed formats are scanned in interleaved samples,
+            // planar ones frame by frame
+            const int ch = input_codec_ctx_->ch_layout.nb_channels;
+            const bool packed = fmt == AV_SAMPLE_FMT_S16 || fmt == AV_SAMPLE_FMT_FLT;
+            units_per_second_ =
+                static_cast<double>(input_codec_ctx_->sample_rate) * (packed ? ch : 1);
+            min_run_units_ =
+                static_cast<int64_t>(params_.min_duration * units_per_second_);
+
+#if defined(__x86_64__) || defined(__i386__)
+            use_avx2_ = (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) != 0;
+#endif
+        } else {
+            // Setup filter graph
+            setup_filter_graph();
+        }
     }
 
     void setup_filter_graph() {
@@ -311,14 +534,32 @@ private:
         report << std::format("  Noise Threshold: {:.1f} dB\n", params_.noise_threshold);
         report << std::format("  Minimum Duration: {:.2f} seconds\n\n", params_.min_duration);
 
-        report << "Results:\n";
-        report << "  Silence segments are logged in FFmpeg output above.\n";
-        report << "  Look for lines starting with '[silencedetect @'.\n\n";
+        if (direct_scan_) {
+            report << "Results:\n";
+            report << std::format("  Silence segments: {}\n\n", segments_.size());
 
-        report << "Note:\n";
-        report << "  The silencedetect filter logs results to stderr/stdout.\n";
-        report << "  To capture programmatically, parse FFmpeg log output or\n";
-        report << "  use custom filter callbacks.\n";
+            double total_silence = 0.0;
+            for (size_t i = 0; i < segments_.size(); ++i) {
+                const auto& seg = segments_[i];
+                report << std::format("  [{:>3}] start {:9.3f}s  end {:9.3f}s  duration {:.3f}s\n",
+                                      i + 1, seg.start_time, seg.end_time, seg.duration);
+                total_silence += seg.duration;
+            }
+            report << std::format("\n  Total silence: {:.3f}s ({:.1f}% of file)\n",
+                                  total_silence,
+                                  total_duration > 0
+                                      ? total_silence / total_duration * 100.0
+                                      : 0.0);
+        } else {
+            report << "Results:\n";
+            report << "  Silence segments are logged in FFmpeg output above.\n";
+            report << "  Look for lines starting with '[silencedetect @'.\n\n";
+
+            report << "Note:\n";
+            report << "  The silencedetect filter logs results to stderr/stdout.\n";
+            report << "  To capture programmatically, parse FFmpeg log output or\n";
+            report << "  use custom filter callbacks.\n";
+        }
 
         std::cout << std::format("\nReport exported to: {}\n", params_.report_file);
     }
@@ -331,8 +572,17 @@ private:
                                 params_.noise_threshold);
         std::cout << std::format("Minimum silence duration: {:.2f} seconds\n",
                                 params_.min_duration);
-        std::cout << "\nTip: Redirect stderr to a file to capture silence timestamps:\n";
-        std::cout << "     ./audio_silence_detect audio.mp3 2> detection.log\n";
+        if (direct_scan_) {
+            double total_silence = 0.0;
+            for (const auto& seg : segments_) {
+                total_silence += seg.duration;
+            }
+            std::cout << std::format("Silence segments: {} ({:.3f}s total)\n",
+                                    segments_.size(), total_silence);
+        } else {
+            std::cout << "\nTip: Redirect stderr to a file to capture silence timestamps:\n";
+            std::cout << "     ./audio_silence_detect audio.mp3 2> detection.log\n";
+        }
     }
 
     std::string input_file_;
@@ -349,6 +599,20 @@ private:
     AVFilterContext* buffersink_ctx_ = nullptr;
 
     int audio_stream_index_ = -1;
+
+    // Direct-scan state
+    bool direct_scan_ = false;
+    AVSampleFormat scan_fmt_ = AV_SAMPLE_FMT_NONE;
+    int16_t thr_s16_ = 0;
+    float thr_flt_ = 0.0f;
+    int64_t min_run_units_ = 0;
+    double units_per_second_ = 1.0;
+    int64_t run_ = 0;
+    int64_t pos_ = 0;
+    std::vector<SilenceSegment> segments_;
+#if defined(__x86_64__) || defined(__i386__)
+    bool use_avx2_ = false;
+#endif
 };
 
 } // anonymous namespace
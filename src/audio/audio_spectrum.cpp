@@ -7,11 +7,20 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <array>
+#include <chrono>
+#include <atomic>
 #include <filesystem>
 #include <format>
 #include <iostream>
 #include <string_view>
-#include <unordered_map>
+#include <thread>
+#include <utility>
 
 namespace fs = std::filesystem;
 
@@ -25,66 +34,235 @@ enum class VisualizationMode {
   SHOWWAVES
 };
 
-VisualizationMode parse_mode(std::string_view mode_str) {
-  static const std::unordered_map<std::string_view, VisualizationMode> modes = {
-      {"spectrum", VisualizationMode::SPECTRUM},
-      {"waveform", VisualizationMode::WAVEFORM},
-      {"showcqt", VisualizationMode::SHOWCQT},
-      {"showfreqs", VisualizationMode::SHOWFREQS},
-      {"showwaves", VisualizationMode::SHOWWAVES}};
-
-  const auto it = modes.find(mode_str);
-  if (it == modes.end()) {
-    throw std::invalid_argument(std::format("Invalid mode: {}", mode_str));
+// Five entries don't justify a hash table: the constexpr array lives
+// in rodata (no static-init guard, no heap buckets) and a linear
+// scan of string_view compares beats an unordered_map probe at this
+// size
+constexpr std::array<std::pair<std::string_view, VisualizationMode>, 5>
+    kModes = {{{"spectrum", VisualizationMode::SPECTRUM},
+               {"waveform", VisualizationMode::WAVEFORM},
+               {"showcqt", VisualizationMode::SHOWCQT},
+               {"showfreqs", VisualizationMode::SHOWFREQS},
+               {"showwaves", VisualizationMode::SHOWWAVES}}};
+
+// Open with a capped probe: the defaults read up to 5 MB / 5 s of
+// input before the first decode, which dwarfs startup for short
+// files. Local audio headers fit comfortably in 64 KiB, and the
+// decoder takes its parameters from codecpar afterwards, so nothing
+// downstream loses information.
+ffmpeg::FormatContextPtr open_audio_input(const char *filename) {
+  AVDictionary *opts = nullptr;
+  av_dict_set(&opts, "probesize", "65536", 0);
+  av_dict_set(&opts, "analyzeduration", "0", 0);
+  auto ctx = ffmpeg::open_input_format(filename, &opts);
+  av_dict_free(&opts);
+  return ctx;
+}
+
+// Returns nullopt for unknown modes -- a bad CLI argument is an
+// expected outcome, not an exceptional one (and the project is
+// C++20, so std::optional stands in for std::expected; the same
+// convention ffmpeg::find_stream_index uses)
+std::optional<VisualizationMode> parse_mode(std::string_view mode_str) {
+  for (const auto &[name, mode] : kModes) {
+    if (name == mode_str) {
+      return mode;
+    }
   }
-  return it->second;
+  return std::nullopt;
 }
 
-std::string get_filter_description(VisualizationMode mode, int width,
-                                   int height) {
+// Filter descriptions top out well under a hundred bytes, so format
+// them NUL-terminated into a stack array instead of a heap string.
+// Every chain ends in format=yuv420p: the visualization filters emit
+// RGB or 4:4:4 frames, and pinning the conversion inside the graph
+// hands the encoder frames it accepts directly (slice-threaded by
+// the graph) instead of relying on a conversion at the encoder's
+// door that avcodec_send_frame won't do for us.
+using FilterDesc = std::array<char, 256>;
+
+FilterDesc get_filter_description(VisualizationMode mode, int width,
+                                  int height) {
+  FilterDesc buf{};
+  const auto finish = [&buf](auto result) {
+    *result.out = '\0';
+    return buf;
+  };
   switch (mode) {
   case VisualizationMode::SPECTRUM:
-    return std::format(
-        "showspectrum=s={}x{}:mode=combined:color=channel:scale=cbrt", width,
-        height);
+    return finish(std::format_to_n(
+        buf.data(), buf.size() - 1,
+        "showspectrum=s={}x{}:mode=combined:color=channel:scale=cbrt"
+        ",format=yuv420p", width,
+        height));
   case VisualizationMode::WAVEFORM:
-    return std::format(
-        "showwaves=s={}x{}:mode=cline:colors=red|green|blue|yellow", width,
-        height);
+    return finish(std::format_to_n(
+        buf.data(), buf.size() - 1,
+        "showwaves=s={}x{}:mode=cline:colors=red|green|blue|yellow"
+        ",format=yuv420p", width,
+        height));
   case VisualizationMode::SHOWCQT:
-    return std::format(
-        "showcqt=s={}x{}:fps=30:sono_h=0:bar_h=16:axis_h=0:font=''", width,
-        height);
+    return finish(std::format_to_n(
+        buf.data(), buf.size() - 1,
+        "showcqt=s={}x{}:fps=30:sono_h=0:bar_h=16:axis_h=0:font=''"
+        ",format=yuv420p", width,
+        height));
   case VisualizationMode::SHOWFREQS:
-    return std::format("showfreqs=s={}x{}:mode=bar:cmode=combined:minamp=1e-6",
-                       width, height);
+    return finish(std::format_to_n(
+        buf.data(), buf.size() - 1,
+        "showfreqs=s={}x{}:mode=bar:cmode=combined:minamp=1e-6"
+        ",format=yuv420p", width,
+        height));
   case VisualizationMode::SHOWWAVES:
-    return std::format(
-        "showwaves=s={}x{}:mode=p2p:colors=0xff0000|0x00ff00|0x0000ff", width,
-        height);
+    return finish(std::format_to_n(
+        buf.data(), buf.size() - 1,
+        "showwaves=s={}x{}:mode=p2p:colors=0xff0000|0x00ff00|0x0000ff"
+        ",format=yuv420p", width,
+        height));
   default:
-    return std::format("showspectrum=s={}x{}", width, height);
+    return finish(std::format_to_n(buf.data(), buf.size() - 1,
+                                   "showspectrum=s={}x{},format=yuv420p", width, height));
   }
 }
 
+// Bounded lock-free SPSC ring handing encoded packets from the
+// encode loop to the writer thread. Push spins when full (encoder
+// got ahead of the disk), pop spins when empty; finish() releases
+// the final drain, after which pop() returns nullptr.
+class PacketRing final {
+public:
+  static constexpr size_t kDepth = 64; // power of two
+
+  void push(AVPacket *pkt) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    while (head - tail_.load(std::memory_order_acquire) >= kDepth) {
+      std::this_thread::yield();
+    }
+    slots_[head & (kDepth - 1)] = pkt;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  AVPacket *pop() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail == head_.load(std::memory_order_acquire)) {
+      if (done_.load(std::memory_order_acquire) &&
+          tail == head_.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      std::this_thread::yield();
+    }
+    AVPacket *pkt = slots_[tail & (kDepth - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return pkt;
+  }
+
+  void finish() { done_.store(true, std::memory_order_release); }
+
+private:
+  std::array<AVPacket *, kDepth> slots_{};
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<bool> done_{false};
+};
+
+// 1 MiB write-side AVIOContext over a plain fd, same as the phaser
+// and pitch-shift samples: avio_open's default context holds ~32 KB,
+// so at typical H.264 frame sizes every frame costs several write(2)
+// calls. The seek callback is needed by the mp4 muxer's trailer pass.
+class BufferedWriter final {
+public:
+  BufferedWriter() = default;
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+  ~BufferedWriter() { close(); }
+
+  AVIOContext *open(const char *path) {
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      return nullptr;
+    }
+    constexpr int kBufSize = 1 << 20;
+    auto *buf = static_cast<unsigned char *>(av_malloc(kBufSize));
+    if (!buf) {
+      close();
+      return nullptr;
+    }
+    io_ = avio_alloc_context(buf, kBufSize, 1, this, nullptr,
+                             &BufferedWriter::write_cb,
+                             &BufferedWriter::seek_cb);
+    if (!io_) {
+      av_free(buf);
+      close();
+      return nullptr;
+    }
+    return io_;
+  }
+
+  void close() {
+    if (io_) {
+      avio_flush(io_);
+      // Custom contexts must not go through avio_closep
+      av_freep(&io_->buffer);
+      avio_context_free(&io_);
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+private:
+  static int write_cb(void *opaque,
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+                      const uint8_t *buf,
+#else
+                      uint8_t *buf,
+#endif
+                      int buf_size) {
+    const auto *self = static_cast<BufferedWriter *>(opaque);
+    const auto n = ::write(self->fd_, buf, static_cast<size_t>(buf_size));
+    return n < 0 ? AVERROR(errno) : static_cast<int>(n);
+  }
+
+  static int64_t seek_cb(void *opaque, int64_t offset, int whence) {
+    auto *self = static_cast<BufferedWriter *>(opaque);
+    if ((whence & ~AVSEEK_FORCE) == AVSEEK_SIZE) {
+      return AVERROR(ENOSYS);
+    }
+    const auto pos = ::lseek(self->fd_, offset, whence & ~AVSEEK_FORCE);
+    return pos < 0 ? AVERROR(errno) : pos;
+  }
+
+  int fd_ = -1;
+  AVIOContext *io_ = nullptr;
+};
+
 class AudioSpectrumVisualizer {
 public:
-  AudioSpectrumVisualizer(std::string_view input_audio,
-                          const fs::path &output_video, VisualizationMode mode,
-                          int width, int height, int fps)
-      : input_audio_(input_audio), output_video_(output_video), mode_(mode),
-        width_(width), height_(height), fps_(fps),
-        format_ctx_(ffmpeg::open_input_format(input_audio.data())),
-        packet_(ffmpeg::create_packet()) {
+  // By-value + move: the caller's strings are sunk straight into the
+  // members instead of being copied out of references
+  AudioSpectrumVisualizer(std::string input_audio, fs::path output_video,
+                          VisualizationMode mode, int width, int height,
+                          int fps)
+      : input_audio_(std::move(input_audio)),
+        output_video_(std::move(output_video)), mode_(mode), width_(width),
+        height_(height), fps_(fps),
+        format_ctx_(open_audio_input(input_audio_.c_str())),
+        encode_packet_(ffmpeg::create_packet()) {
 
     initialize();
   }
 
   void generate() {
+    // fs::path::string() materializes a fresh heap string per call;
+    // do it once for the four uses below
+    const std::string out_path = output_video_.string();
+
     std::cout << "Audio Spectrum Visualization\n";
     std::cout << "============================\n\n";
     std::cout << std::format("Input audio: {}\n", input_audio_);
-    std::cout << std::format("Output video: {}\n", output_video_.string());
+    std::cout << std::format("Output video: {}\n", out_path);
     std::cout << std::format("Resolution: {}x{}\n", width_, height_);
     std::cout << std::format("FPS: {}\n", fps_);
     std::cout << std::format("Sample rate: {} Hz\n\n", codec_ctx_->sample_rate);
@@ -93,7 +271,7 @@ public:
     AVFormatContext *output_ctx_raw = nullptr;
     ffmpeg::check_error(
         avformat_alloc_output_context2(&output_ctx_raw, nullptr, nullptr,
-                                       output_video_.string().c_str()),
+                                       out_path.c_str()),
         "allocate output context");
     auto output_ctx = ffmpeg::FormatContextPtr(output_ctx_raw);
 
@@ -103,26 +281,77 @@ public:
       throw ffmpeg::FFmpegError("Failed to create output stream");
     }
 
-    // Setup encoder
-    const auto *encoder = avcodec_find_encoder(AV_CODEC_ID_H264);
-    if (!encoder) {
-      throw ffmpeg::FFmpegError("H.264 encoder not found");
-    }
+    // Setup encoder: software x264 dominates the pipeline's runtime,
+    // so prefer the dedicated hardware blocks when one is usable.
+    // All of these accept system-memory yuv420p frames and upload
+    // internally, which keeps the filter graph unchanged (the same
+    // simplification video_hw_encode makes). An encoder can be
+    // compiled in yet have no device at runtime, so probing has to
+    // go through avcodec_open2, not just the name lookup.
+    static constexpr std::array<const char *, 4> kEncoderPreference = {
+        "h264_nvenc", "h264_qsv", "h264_videotoolbox", "libx264"};
+
+    const auto try_open_encoder = [&](const AVCodec *candidate) {
+      if (!candidate) {
+        return false;
+      }
+      auto ctx = ffmpeg::create_codec_context(candidate);
+      ctx->width = width_;
+      ctx->height = height_;
+      ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+      ctx->time_base = AVRational{1, fps_};
+      ctx->framerate = AVRational{fps_, 1};
+      ctx->bit_rate = 2000000;
+
+      if (output_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+        ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+      }
 
-    encoder_ctx_ = ffmpeg::create_codec_context(encoder);
-    encoder_ctx_->width = width_;
-    encoder_ctx_->height = height_;
-    encoder_ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
-    encoder_ctx_->time_base = AVRational{1, fps_};
-    encoder_ctx_->framerate = AVRational{fps_, 1};
-    encoder_ctx_->bit_rate = 2000000;
+      // Same throughput-over-latency threading as the decoder; the
+      // hardware encoders ignore it and x264 spreads across cores
+      ctx->thread_count = 0; // auto-detect core count
+      ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+      if (std::string_view{candidate->name} == "h264_nvenc") {
+        // Medium-quality preset with VBR at a fixed quality target;
+        // bit_rate above then only caps the rate
+        av_opt_set(ctx->priv_data, "preset", "p4", 0);
+        av_opt_set(ctx->priv_data, "rc", "vbr", 0);
+        av_opt_set(ctx->priv_data, "cq", "23", 0);
+      } else if (std::string_view{candidate->name} == "libx264") {
+        // Spectrum frames have low visual complexity, so the default
+        // medium preset buys nothing over ultrafast here except 5-10x
+        // the encode time. Not tune=zerolatency: that trades away the
+        // lookahead and frame-threading pipeline for latency this
+        // batch tool doesn't care about. Keyframes every two seconds
+        // keep the output seekable.
+        av_opt_set(ctx->priv_data, "preset", "ultrafast", 0);
+        const auto keyint = std::format("keyint={}", fps_ * 2);
+        av_opt_set(ctx->priv_data, "x264-params", keyint.c_str(), 0);
+      }
 
-    if (output_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
-      encoder_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+      if (avcodec_open2(ctx.get(), candidate, nullptr) < 0) {
+        return false;
+      }
+      encoder_ctx_ = std::move(ctx);
+      return true;
+    };
+
+    const AVCodec *encoder = nullptr;
+    for (const char *name : kEncoderPreference) {
+      if (const auto *candidate = avcodec_find_encoder_by_name(name);
+          try_open_encoder(candidate)) {
+        encoder = candidate;
+        break;
+      }
     }
-
-    ffmpeg::check_error(avcodec_open2(encoder_ctx_.get(), encoder, nullptr),
-                        "open encoder");
+    if (!encoder && try_open_encoder(avcodec_find_encoder(AV_CODEC_ID_H264))) {
+      encoder = avcodec_find_encoder(AV_CODEC_ID_H264);
+    }
+    if (!encoder) {
+      throw ffmpeg::FFmpegError("No usable H.264 encoder found");
+    }
+    std::cout << std::format("Encoder: {}\n", encoder->name);
 
     ffmpeg::check_error(avcodec_parameters_from_context(out_stream->codecpar,
                                                         encoder_ctx_.get()),
@@ -130,12 +359,14 @@ public:
 
     out_stream->time_base = encoder_ctx_->time_base;
 
-    // Open output file
+    // Open output file through the 1 MiB buffered writer; don't
+    // force a flush per interleaved packet either
     if (!(output_ctx->oformat->flags & AVFMT_NOFILE)) {
-      ffmpeg::check_error(avio_open(&output_ctx->pb,
-                                    output_video_.string().c_str(),
-                                    AVIO_FLAG_WRITE),
-                          "open output file");
+      output_ctx->pb = writer_.open(out_path.c_str());
+      if (!output_ctx->pb) {
+        throw ffmpeg::FFmpegError("Failed to open output file");
+      }
+      output_ctx->flush_packets = 0;
     }
 
     // Write header
@@ -147,104 +378,182 @@ public:
 
     int frame_count = 0;
     auto video_frame = ffmpeg::create_frame();
-
-    while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
-      ffmpeg::ScopedPacketUnref packet_guard(packet_.get());
-
-      if (packet_->stream_index != audio_stream_index_) {
-        continue;
-      }
-
-      const auto ret = avcodec_send_packet(codec_ctx_.get(), packet_.get());
-      if (ret < 0) {
-        continue;
+    // One decoded-frame shell for the whole run; the per-iteration
+    // guard unrefs the payload, the shell itself is never reallocated
+    auto audio_frame = ffmpeg::create_frame();
+
+    // Hoist the smart-pointer and member loads out of the loops;
+    // the raw pointers are loop-invariant and can live in registers
+    AVCodecContext *dec = codec_ctx_.get();
+    AVFilterContext *src = buffersrc_ctx_;
+    AVFilterContext *sink = buffersink_ctx_;
+
+    // Muxing runs on its own thread so disk I/O overlaps the encode
+    // of the next frame; the ring bounds in-flight packets
+    std::thread writer([this, &output_ctx] {
+      while (AVPacket *pkt = write_queue_.pop()) {
+        if (write_status_.load(std::memory_order_relaxed) == 0) {
+          const auto ret = av_interleaved_write_frame(output_ctx.get(), pkt);
+          if (ret < 0) {
+            write_status_.store(ret, std::memory_order_relaxed);
+          }
+        }
+        av_packet_free(&pkt);
       }
-
-      while (true) {
-        auto audio_frame = ffmpeg::create_frame();
-        const auto recv_ret =
-            avcodec_receive_frame(codec_ctx_.get(), audio_frame.get());
-
-        if (recv_ret == AVERROR(EAGAIN) || recv_ret == AVERROR_EOF) {
+    });
+
+    // Demuxing gets its own thread too: av_read_frame blocks on
+    // input I/O, which now overlaps decode/filter/encode. EOF is the
+    // ring running dry after finish(); read errors are latched.
+    PacketRing demux_queue;
+    std::atomic<int> demux_status{0};
+    std::thread demuxer([this, &demux_queue, &demux_status] {
+      for (;;) {
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt) {
+          demux_status.store(AVERROR(ENOMEM), std::memory_order_relaxed);
           break;
         }
-
-        if (recv_ret < 0) {
+        const auto ret = av_read_frame(format_ctx_.get(), pkt);
+        if (ret < 0) {
+          av_packet_free(&pkt);
+          if (ret != AVERROR_EOF) {
+            demux_status.store(ret, std::memory_order_relaxed);
+          }
           break;
         }
+        // Belt and braces next to the AVDISCARD_ALL setup: anything
+        // that still isn't audio is dropped before it costs a ring
+        // slot
+        if (pkt->stream_index != audio_stream_index_) {
+          av_packet_free(&pkt);
+          continue;
+        }
+        demux_queue.push(pkt);
+      }
+      demux_queue.finish();
+    });
+
+    // Drain-and-join for every exit: the demuxer may be blocked on a
+    // full ring, so consume until the sentinel before joining
+    const auto stop_demuxer = [&] {
+      while (AVPacket *pkt = demux_queue.pop()) {
+        av_packet_free(&pkt);
+      }
+      demuxer.join();
+    };
 
-        ffmpeg::ScopedFrameUnref audio_guard(audio_frame.get());
+    try {
+      while (AVPacket *raw_pkt = demux_queue.pop()) {
+        ffmpeg::PacketPtr in_packet(raw_pkt);
 
-        // Push audio frame through filter
-        ffmpeg::check_error(
-            av_buffersrc_add_frame_flags(buffersrc_ctx_, audio_frame.get(),
-                                         AV_BUFFERSRC_FLAG_KEEP_REF),
-            "feed audio frame to filter");
+        const auto ret = avcodec_send_packet(dec, in_packet.get());
+        if (ret < 0) {
+          continue;
+        }
 
-        // Get video frames from filter
         while (true) {
-          const auto filter_ret =
-              av_buffersink_get_frame(buffersink_ctx_, video_frame.get());
+          const auto recv_ret =
+              avcodec_receive_frame(dec, audio_frame.get());
 
-          if (filter_ret == AVERROR(EAGAIN) || filter_ret == AVERROR_EOF) {
+          if (recv_ret == AVERROR(EAGAIN) || recv_ret == AVERROR_EOF) {
             break;
           }
 
-          if (filter_ret < 0) {
+          if (recv_ret < 0) {
             break;
           }
 
-          ffmpeg::ScopedFrameUnref video_guard(video_frame.get());
+          ffmpeg::ScopedFrameUnref audio_guard(audio_frame.get());
+
+          // Hand the frame's buffer references to the graph (flag 0)
+          // instead of making it take its own with KEEP_REF -- we
+          // only reuse the shell, never the payload. The guard still
+          // covers the paths where the frame isn't consumed.
+          ffmpeg::check_error(
+              av_buffersrc_add_frame_flags(src, audio_frame.get(), 0),
+              "feed audio frame to filter");
 
-          // Set correct PTS
-          video_frame->pts = frame_count++;
+          // Get video frames from filter
+          while (true) {
+            const auto filter_ret =
+                av_buffersink_get_frame(sink, video_frame.get());
 
-          // Encode and write frame
-          encode_write_frame(output_ctx.get(), out_stream, video_frame.get());
+            if (filter_ret == AVERROR(EAGAIN) || filter_ret == AVERROR_EOF) {
+              break;
+            }
 
-          if (frame_count % 30 == 0) {
-            const auto seconds = frame_count / static_cast<double>(fps_);
-            std::cout << std::format("Generated {:.2f} seconds\r", seconds)
-                      << std::flush;
+            if (filter_ret < 0) {
+              break;
+            }
+
+            ffmpeg::ScopedFrameUnref video_guard(video_frame.get());
+
+            // Set correct PTS
+            video_frame->pts = frame_count++;
+
+            // Encode and write frame
+            encode_write_frame(out_stream, video_frame.get());
+
+            report_progress(frame_count);
           }
         }
       }
-    }
 
-    // Flush filter
-    if (av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0) < 0) {
-      std::cerr << "Error flushing filter graph\n";
-    }
+      // Flush filter
+      if (av_buffersrc_add_frame_flags(src, nullptr, 0) < 0) {
+        std::cerr << "Error flushing filter graph\n";
+      }
 
-    while (true) {
-      const auto filter_ret =
-          av_buffersink_get_frame(buffersink_ctx_, video_frame.get());
+      while (true) {
+        const auto filter_ret =
+            av_buffersink_get_frame(sink, video_frame.get());
 
-      if (filter_ret == AVERROR(EAGAIN) || filter_ret == AVERROR_EOF) {
-        break;
-      }
+        if (filter_ret == AVERROR(EAGAIN) || filter_ret == AVERROR_EOF) {
+          break;
+        }
 
-      if (filter_ret < 0) {
-        break;
-      }
+        if (filter_ret < 0) {
+          break;
+        }
 
-      ffmpeg::ScopedFrameUnref video_guard(video_frame.get());
+        ffmpeg::ScopedFrameUnref video_guard(video_frame.get());
 
-      video_frame->pts = frame_count++;
-      encode_write_frame(output_ctx.get(), out_stream, video_frame.get());
+        video_frame->pts = frame_count++;
+        encode_write_frame(out_stream, video_frame.get());
+      }
+
+      // Flush encoder
+      flush_encoder(out_stream);
+    } catch (...) {
+      // Release both helper threads before unwinding so every
+      // in-flight packet is drained and freed exactly once
+      stop_demuxer();
+      write_queue_.finish();
+      writer.join();
+      throw;
     }
 
-    // Flush encoder
-    flush_encoder(output_ctx.get(), out_stream);
+    stop_demuxer();
+    ffmpeg::check_error(demux_status.load(), "read input");
+
+    write_queue_.finish();
+    writer.join();
+    ffmpeg::check_error(write_status_.load(), "write frame");
 
     // Write trailer
     ffmpeg::check_error(av_write_trailer(output_ctx.get()), "write trailer");
 
+    // Detach the custom context before the format context's deleter
+    // runs -- avio_close assumes avio_open-created contexts
+    output_ctx->pb = nullptr;
+    writer_.close();
+
     const auto duration = frame_count / static_cast<double>(fps_);
     std::cout << std::format("\n\nTotal frames: {}\n", frame_count);
     std::cout << std::format("Duration: {:.2f} seconds\n", duration);
     std::cout << std::format("✓ Visualization generated successfully\n");
-    std::cout << std::format("Output file: {}\n", output_video_.string());
+    std::cout << std::format("Output file: {}\n", out_path);
   }
 
 private:
@@ -257,6 +566,15 @@ private:
     }
     audio_stream_index_ = *stream_idx;
 
+    // Make the demuxer drop every other stream at the source --
+    // video/subtitle packets of a muxed input then never get read,
+    // allocated or queued just to be discarded by the loop
+    for (unsigned i = 0; i < format_ctx_->nb_streams; ++i) {
+      if (static_cast<int>(i) != audio_stream_index_) {
+        format_ctx_->streams[i]->discard = AVDISCARD_ALL;
+      }
+    }
+
     // Setup decoder
     const auto *codecpar = format_ctx_->streams[audio_stream_index_]->codecpar;
     const auto *decoder = avcodec_find_decoder(codecpar->codec_id);
@@ -268,6 +586,12 @@ private:
     ffmpeg::check_error(
         avcodec_parameters_to_context(codec_ctx_.get(), codecpar),
         "copy decoder parameters");
+    // Thread the decode wherever the codec supports it; this is an
+    // offline batch tool, so the extra frames of latency frame
+    // threading adds are irrelevant next to the throughput
+    codec_ctx_->thread_count = 0; // auto-detect core count
+    codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
     ffmpeg::check_error(avcodec_open2(codec_ctx_.get(), decoder, nullptr),
                         "open decoder");
 
@@ -284,18 +608,28 @@ private:
       throw ffmpeg::FFmpegError("Failed to allocate filter graph");
     }
 
+    // The visualization filters do per-frame FFTs and pixel painting
+    // that slice cleanly; let the graph spread them over all cores
+    // (same setting the reverb tool uses on its graph)
+    filter_graph_->thread_type = AVFILTER_THREAD_SLICE;
+    filter_graph_->nb_threads =
+        static_cast<int>(std::thread::hardware_concurrency());
+
     // Create audio buffer source
     char ch_layout[64];
     av_channel_layout_describe(&codec_ctx_->ch_layout, ch_layout,
                                sizeof(ch_layout));
 
-    const auto args = std::format(
+    std::array<char, 192> args{};
+    const auto args_res = std::format_to_n(
+        args.data(), args.size() - 1,
         "sample_rate={}:sample_fmt={}:channel_layout={}:time_base={}/{}",
         codec_ctx_->sample_rate, av_get_sample_fmt_name(codec_ctx_->sample_fmt),
         ch_layout, 1, codec_ctx_->sample_rate);
+    *args_res.out = '\0';
 
     ffmpeg::check_error(avfilter_graph_create_filter(
-                            &buffersrc_ctx_, abuffersrc, "in", args.c_str(),
+                            &buffersrc_ctx_, abuffersrc, "in", args.data(),
                             nullptr, filter_graph_.get()),
                         "create audio buffer source");
 
@@ -328,7 +662,7 @@ private:
     inputs->next = nullptr;
 
     const auto ret = avfilter_graph_parse_ptr(
-        filter_graph_.get(), filter_desc.c_str(), &inputs, &outputs, nullptr);
+        filter_graph_.get(), filter_desc.data(), &inputs, &outputs, nullptr);
     avfilter_inout_free(&inputs);
     avfilter_inout_free(&outputs);
 
@@ -338,42 +672,68 @@ private:
                         "configure filter graph");
   }
 
-  void encode_write_frame(AVFormatContext *output_ctx, AVStream *out_stream,
-                          AVFrame *frame) {
-    auto encoded_packet = ffmpeg::create_packet();
-
-    const auto ret = avcodec_send_frame(encoder_ctx_.get(), frame);
-    if (ret < 0) {
+  // Interactive-only, wall-clock throttled progress line: skip
+  // entirely when stdout is redirected, and when on a TTY format
+  // into a stack buffer and write(2) it directly -- no stream lock,
+  // no flush, at most one syscall per second regardless of frame
+  // rate
+  void report_progress(int frame_count) {
+    static const bool is_tty = isatty(fileno(stdout)) != 0;
+    if (!is_tty) {
       return;
     }
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_report_) {
+      return;
+    }
+    next_report_ = now + std::chrono::seconds(1);
+    char buf[64];
+    const auto res = std::format_to_n(
+        buf, sizeof(buf), "Generated {:.2f} seconds\r",
+        frame_count / static_cast<double>(fps_));
+    [[maybe_unused]] const ssize_t n =
+        ::write(STDOUT_FILENO, buf, static_cast<size_t>(res.size));
+  }
 
-    while (avcodec_receive_packet(encoder_ctx_.get(), encoded_packet.get()) >=
-           0) {
-      ffmpeg::ScopedPacketUnref packet_guard(encoded_packet.get());
-
-      av_packet_rescale_ts(encoded_packet.get(), encoder_ctx_->time_base,
-                           out_stream->time_base);
-      encoded_packet->stream_index = out_stream->index;
+  // Timestamps are fixed up here (producer side) so the writer
+  // thread only ever muxes and frees
+  void enqueue_packet(AVStream *out_stream, AVPacket *staging) {
+    av_packet_rescale_ts(staging, encoder_ctx_->time_base,
+                         out_stream->time_base);
+    staging->stream_index = out_stream->index;
 
-      ffmpeg::check_error(
-          av_interleaved_write_frame(output_ctx, encoded_packet.get()),
-          "write frame");
+    AVPacket *pkt = av_packet_alloc();
+    if (!pkt) {
+      throw ffmpeg::FFmpegError("Failed to allocate packet");
     }
+    av_packet_move_ref(pkt, staging);
+    write_queue_.push(pkt);
   }
 
-  void flush_encoder(AVFormatContext *output_ctx, AVStream *out_stream) {
-    avcodec_send_frame(encoder_ctx_.get(), nullptr);
+  void encode_write_frame(AVStream *out_stream, AVFrame *frame) {
+    AVCodecContext *enc = encoder_ctx_.get();
+    AVPacket *staging = encode_packet_.get();
 
-    auto encoded_packet = ffmpeg::create_packet();
-    while (avcodec_receive_packet(encoder_ctx_.get(), encoded_packet.get()) >=
-           0) {
-      ffmpeg::ScopedPacketUnref packet_guard(encoded_packet.get());
+    const auto ret = avcodec_send_frame(enc, frame);
+    if (ret < 0) {
+      return;
+    }
 
-      av_packet_rescale_ts(encoded_packet.get(), encoder_ctx_->time_base,
-                           out_stream->time_base);
-      encoded_packet->stream_index = out_stream->index;
+    // encode_packet_ is a reusable staging shell: receive fills it,
+    // enqueue_packet moves the payload out, leaving it clean
+    while (avcodec_receive_packet(enc, staging) >= 0) {
+      enqueue_packet(out_stream, staging);
+    }
+  }
+
+  void flush_encoder(AVStream *out_stream) {
+    AVCodecContext *enc = encoder_ctx_.get();
+    AVPacket *staging = encode_packet_.get();
 
-      av_interleaved_write_frame(output_ctx, encoded_packet.get());
+    avcodec_send_frame(enc, nullptr);
+
+    while (avcodec_receive_packet(enc, staging) >= 0) {
+      enqueue_packet(out_stream, staging);
     }
   }
 
@@ -389,10 +749,15 @@ private:
   ffmpeg::CodecContextPtr codec_ctx_;
   ffmpeg::CodecContextPtr encoder_ctx_;
   ffmpeg::FilterGraphPtr filter_graph_;
-  ffmpeg::PacketPtr packet_;
+  ffmpeg::PacketPtr encode_packet_;
 
   AVFilterContext *buffersrc_ctx_ = nullptr;
   AVFilterContext *buffersink_ctx_ = nullptr;
+
+  BufferedWriter writer_;
+  PacketRing write_queue_;
+  std::atomic<int> write_status_{0};
+  std::chrono::steady_clock::time_point next_report_{};
 };
 
 void print_usage(std::string_view prog_name) {
@@ -426,14 +791,20 @@ int main(int argc, char *argv[]) {
   }
 
   try {
-    const std::string_view input_audio{argv[1]};
-    const fs::path output_video{argv[2]};
+    std::string input_audio{argv[1]};
+    fs::path output_video{argv[2]};
     const auto mode = parse_mode(argv[3]);
+    if (!mode) {
+      std::cerr << std::format("Invalid mode: {}\n", argv[3]);
+      print_usage(argv[0]);
+      return 1;
+    }
     const int width = argc > 4 ? std::atoi(argv[4]) : 1280;
     const int height = argc > 5 ? std::atoi(argv[5]) : 720;
     const int fps = argc > 6 ? std::atoi(argv[6]) : 30;
 
-    AudioSpectrumVisualizer visualizer(input_audio, output_video, mode, width,
+    AudioSpectrumVisualizer visualizer(std::move(input_audio),
+                                       std::move(output_video), *mode, width,
                                        height, fps);
     visualizer.generate();
 
@@ -16,6 +16,13 @@
 
 #include "ffmpeg_wrappers.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <format>
@@ -23,12 +30,23 @@
 #include <string_view>
 #include <filesystem>
 #include <optional>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavfilter/buffersink.h>
 #include <libavfilter/buffersrc.h>
+#include <libavutil/cpu.h>
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <unistd.h>
+
 namespace fs = std::filesystem;
 
 namespace {
@@ -63,6 +81,450 @@ struct StereoParams {
     std::string preset;
 };
 
+// ---------------------------------------------------------------------------
+// In-process stereo kernels for packed (interleaved) s16 PCM.
+//
+// Every operation except width is a per-sample linear combination, so
+// routing it through libavfilter buys nothing but per-frame frame
+// allocation, ref-counting and negotiation overhead. These kernels
+// run directly on the decoded frame buffer instead -- the same move
+// FFmpeg makes internally with its ff_mix_2_to_1_* SIMD mixers.
+// Matrix coefficients are Q12 fixed point (4096 = unity), which keeps
+// gains up to +18 dB representable.
+// ---------------------------------------------------------------------------
+
+inline int16_t clip_s16(int v) {
+    return static_cast<int16_t>(std::clamp(v, -32768, 32767));
+}
+
+inline void stereo_matrix_s16_scalar(int16_t* samples, size_t frames,
+                                     int16_t a00, int16_t a01,
+                                     int16_t a10, int16_t a11) {
+    for (size_t i = 0; i < frames; ++i) {
+        const int l = samples[2 * i];
+        const int r = samples[2 * i + 1];
+        samples[2 * i] = clip_s16((l * a00 + r * a01 + (1 << 11)) >> 12);
+        samples[2 * i + 1] = clip_s16((l * a10 + r * a11 + (1 << 11)) >> 12);
+    }
+}
+
+inline void swap_channels_s16_scalar(int16_t* samples, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        std::swap(samples[2 * i], samples[2 * i + 1]);
+    }
+}
+
+inline void invert_phase_s16_scalar(int16_t* samples, size_t frames,
+                                    bool left, bool right) {
+    for (size_t i = 0; i < frames; ++i) {
+        if (left) {
+            samples[2 * i] = clip_s16(-samples[2 * i]);
+        }
+        if (right) {
+            samples[2 * i + 1] = clip_s16(-samples[2 * i + 1]);
+        }
+    }
+}
+
+inline void downmix_to_mono_scalar(const int16_t* in, int16_t* out,
+                                   size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        out[i] = static_cast<int16_t>((in[2 * i] + in[2 * i + 1] + 1) >> 1);
+    }
+}
+
+inline void duplicate_to_stereo_scalar(const int16_t* in, int16_t* out,
+                                       size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        out[2 * i] = in[i];
+        out[2 * i + 1] = in[i];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// out = A * [l r]^T, eight stereo frames per iteration. madd_epi16
+// multiplies each interleaved [l r] pair against a coefficient pair
+// and sums into 32 bits, so no deinterleave shuffle is needed; the
+// rounded shift and packs_epi32 return saturated s16 in interleaved
+// order.
+__attribute__((target("avx2"))) inline void
+stereo_matrix_s16_avx2(int16_t* samples, size_t frames, int16_t a00,
+                       int16_t a01, int16_t a10, int16_t a11) {
+    const auto pair = [](int16_t lo, int16_t hi) {
+        return static_cast<int>(
+            static_cast<uint16_t>(lo) |
+            (static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16));
+    };
+    const __m256i row_l = _mm256_set1_epi32(pair(a00, a01));
+    const __m256i row_r = _mm256_set1_epi32(pair(a10, a11));
+    const __m256i round = _mm256_set1_epi32(1 << 11);
+
+    size_t i = 0;
+
+    // Four independent blocks per iteration so the multiply chains
+    // overlap instead of serializing on pmaddwd latency; all loads
+    // are issued before any store touches the same region
+    for (; i + 32 <= frames; i += 32) {
+        auto* p = samples + 2 * i;
+        const __m256i v0 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i v1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 16));
+        const __m256i v2 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        const __m256i v3 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 48));
+
+        const __m256i l0 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v0, row_l), round), 12);
+        const __m256i l1 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v1, row_l), round), 12);
+        const __m256i l2 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v2, row_l), round), 12);
+        const __m256i l3 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v3, row_l), round), 12);
+        const __m256i r0 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v0, row_r), round), 12);
+        const __m256i r1 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v1, row_r), round), 12);
+        const __m256i r2 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v2, row_r), round), 12);
+        const __m256i r3 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v3, row_r), round), 12);
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(p),
+            _mm256_packs_epi32(_mm256_unpacklo_epi32(l0, r0),
+                               _mm256_unpackhi_epi32(l0, r0)));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(p + 16),
+            _mm256_packs_epi32(_mm256_unpacklo_epi32(l1, r1),
+                               _mm256_unpackhi_epi32(l1, r1)));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(p + 32),
+            _mm256_packs_epi32(_mm256_unpacklo_epi32(l2, r2),
+                               _mm256_unpackhi_epi32(l2, r2)));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(p + 48),
+            _mm256_packs_epi32(_mm256_unpacklo_epi32(l3, r3),
+                               _mm256_unpackhi_epi32(l3, r3)));
+    }
+
+    for (; i + 8 <= frames; i += 8) {
+        const __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(samples + 2 * i));
+        const __m256i l32 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v, row_l), round), 12);
+        const __m256i r32 = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(v, row_r), round), 12);
+        const __m256i lo = _mm256_unpacklo_epi32(l32, r32);
+        const __m256i hi = _mm256_unpackhi_epi32(l32, r32);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(samples + 2 * i),
+                            _mm256_packs_epi32(lo, hi));
+    }
+    stereo_matrix_s16_scalar(samples + 2 * i, frames - i, a00, a01, a10, a11);
+}
+
+__attribute__((target("avx2"))) inline void
+swap_channels_s16_avx2(int16_t* samples, size_t frames) {
+    const __m256i mask = _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(samples + 2 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(samples + 2 * i),
+                            _mm256_shuffle_epi8(v, mask));
+    }
+    swap_channels_s16_scalar(samples + 2 * i, frames - i);
+}
+
+// Saturating negate (subs from zero maps -32768 to 32767) on the
+// selected channel lanes only
+__attribute__((target("avx2"))) inline void
+invert_phase_s16_avx2(int16_t* samples, size_t frames, bool left,
+                      bool right) {
+    const __m256i sel = _mm256_set1_epi32(
+        left && right ? -1
+        : left        ? 0x0000FFFF
+                      : static_cast<int>(0xFFFF0000));
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(samples + 2 * i));
+        const __m256i neg = _mm256_subs_epi16(zero, v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(samples + 2 * i),
+                            _mm256_blendv_epi8(v, neg, sel));
+    }
+    invert_phase_s16_scalar(samples + 2 * i, frames - i, left, right);
+}
+
+__attribute__((target("avx2"))) inline void
+duplicate_to_stereo_avx2(const int16_t* in, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i lo = _mm256_unpacklo_epi16(v, v);
+        const __m256i hi = _mm256_unpackhi_epi16(v, v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i),
+                            _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 16),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    duplicate_to_stereo_scalar(in + i, out + 2 * i, frames - i);
+}
+
+// Rounding (l+r+1)/2 downmix, 16 stereo frames per iteration:
+// madd against ones sums each interleaved pair into 32 bits, so no
+// sign-bias XOR or deinterleave shuffle is needed; the permute fixes
+// packs_epi32's per-lane output order
+__attribute__((target("avx2"))) inline void
+downmix_to_mono_avx2(const int16_t* in, int16_t* out, size_t frames) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i round = _mm256_set1_epi32(1);
+
+    size_t i = 0;
+    for (; i + 16 <= frames; i += 16) {
+        const __m256i va = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(in + 2 * i));
+        const __m256i vb = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(in + 2 * i + 16));
+        const __m256i sa = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(va, ones), round), 1);
+        const __m256i sb = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(vb, ones), round), 1);
+        const __m256i packed = _mm256_packs_epi32(sa, sb);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    downmix_to_mono_scalar(in + 2 * i, out + i, frames - i);
+}
+
+// SSE2 tier for x86 hosts without AVX2 -- same structure at 128-bit
+// width; madd_epi16 and packs_epi32 are both SSE2
+__attribute__((target("sse2"))) inline void
+stereo_matrix_s16_sse2(int16_t* samples, size_t frames, int16_t a00,
+                       int16_t a01, int16_t a10, int16_t a11) {
+    const auto pair = [](int16_t lo, int16_t hi) {
+        return static_cast<int>(
+            static_cast<uint16_t>(lo) |
+            (static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16));
+    };
+    const __m128i row_l = _mm_set1_epi32(pair(a00, a01));
+    const __m128i row_r = _mm_set1_epi32(pair(a10, a11));
+    const __m128i round = _mm_set1_epi32(1 << 11);
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(samples + 2 * i));
+        const __m128i l32 = _mm_srai_epi32(
+            _mm_add_epi32(_mm_madd_epi16(v, row_l), round), 12);
+        const __m128i r32 = _mm_srai_epi32(
+            _mm_add_epi32(_mm_madd_epi16(v, row_r), round), 12);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + 2 * i),
+                         _mm_packs_epi32(_mm_unpacklo_epi32(l32, r32),
+                                         _mm_unpackhi_epi32(l32, r32)));
+    }
+    stereo_matrix_s16_scalar(samples + 2 * i, frames - i, a00, a01, a10, a11);
+}
+
+__attribute__((target("sse2"))) inline void
+swap_channels_s16_sse2(int16_t* samples, size_t frames) {
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(samples + 2 * i));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + 2 * i), v);
+    }
+    swap_channels_s16_scalar(samples + 2 * i, frames - i);
+}
+
+__attribute__((target("sse2"))) inline void
+invert_phase_s16_sse2(int16_t* samples, size_t frames, bool left,
+                      bool right) {
+    const __m128i sel = _mm_set1_epi32(
+        left && right ? -1
+        : left        ? 0x0000FFFF
+                      : static_cast<int>(0xFFFF0000));
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(samples + 2 * i));
+        const __m128i neg = _mm_subs_epi16(zero, v);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + 2 * i),
+                         _mm_or_si128(_mm_and_si128(sel, neg),
+                                      _mm_andnot_si128(sel, v)));
+    }
+    invert_phase_s16_scalar(samples + 2 * i, frames - i, left, right);
+}
+
+__attribute__((target("sse2"))) inline void
+duplicate_to_stereo_sse2(const int16_t* in, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i),
+                         _mm_unpacklo_epi16(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 8),
+                         _mm_unpackhi_epi16(v, v));
+    }
+    duplicate_to_stereo_scalar(in + i, out + 2 * i, frames - i);
+}
+
+__attribute__((target("sse2"))) inline void
+downmix_to_mono_sse2(const int16_t* in, int16_t* out, size_t frames) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32(1);
+
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m128i va =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        const __m128i vb =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 8));
+        const __m128i sa = _mm_srai_epi32(
+            _mm_add_epi32(_mm_madd_epi16(va, ones), round), 1);
+        const __m128i sb = _mm_srai_epi32(
+            _mm_add_epi32(_mm_madd_epi16(vb, ones), round), 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packs_epi32(sa, sb));
+    }
+    downmix_to_mono_scalar(in + 2 * i, out + i, frames - i);
+}
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+// NEON variants. vld2q/vst2q fold the stereo (de)interleave into the
+// load/store itself, so the matrix rows run on already-split L/R
+// vectors; vqrshrn does the rounded Q12 narrowing with saturation.
+inline void stereo_matrix_s16_neon(int16_t* samples, size_t frames,
+                                   int16_t a00, int16_t a01, int16_t a10,
+                                   int16_t a11) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t v = vld2q_s16(samples + 2 * i);
+        const int16x4_t l_lo = vget_low_s16(v.val[0]);
+        const int16x4_t l_hi = vget_high_s16(v.val[0]);
+        const int16x4_t r_lo = vget_low_s16(v.val[1]);
+        const int16x4_t r_hi = vget_high_s16(v.val[1]);
+
+        const int32x4_t out_l_lo =
+            vmlal_n_s16(vmull_n_s16(l_lo, a00), r_lo, a01);
+        const int32x4_t out_l_hi =
+            vmlal_n_s16(vmull_n_s16(l_hi, a00), r_hi, a01);
+        const int32x4_t out_r_lo =
+            vmlal_n_s16(vmull_n_s16(l_lo, a10), r_lo, a11);
+        const int32x4_t out_r_hi =
+            vmlal_n_s16(vmull_n_s16(l_hi, a10), r_hi, a11);
+
+        v.val[0] = vcombine_s16(vqrshrn_n_s32(out_l_lo, 12),
+                                vqrshrn_n_s32(out_l_hi, 12));
+        v.val[1] = vcombine_s16(vqrshrn_n_s32(out_r_lo, 12),
+                                vqrshrn_n_s32(out_r_hi, 12));
+        vst2q_s16(samples + 2 * i, v);
+    }
+    stereo_matrix_s16_scalar(samples + 2 * i, frames - i, a00, a01, a10, a11);
+}
+
+inline void swap_channels_s16_neon(int16_t* samples, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t v = vld2q_s16(samples + 2 * i);
+        std::swap(v.val[0], v.val[1]);
+        vst2q_s16(samples + 2 * i, v);
+    }
+    swap_channels_s16_scalar(samples + 2 * i, frames - i);
+}
+
+inline void invert_phase_s16_neon(int16_t* samples, size_t frames,
+                                  bool left, bool right) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t v = vld2q_s16(samples + 2 * i);
+        if (left) {
+            v.val[0] = vqnegq_s16(v.val[0]);
+        }
+        if (right) {
+            v.val[1] = vqnegq_s16(v.val[1]);
+        }
+        vst2q_s16(samples + 2 * i, v);
+    }
+    invert_phase_s16_scalar(samples + 2 * i, frames - i, left, right);
+}
+
+// vrhadd is the rounding halving add, exactly (l+r+1)>>1
+inline void downmix_to_mono_neon(const int16_t* in, int16_t* out,
+                                 size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const int16x8x2_t v = vld2q_s16(in + 2 * i);
+        vst1q_s16(out + i, vrhaddq_s16(v.val[0], v.val[1]));
+    }
+    downmix_to_mono_scalar(in + 2 * i, out + i, frames - i);
+}
+
+inline void duplicate_to_stereo_neon(const int16_t* in, int16_t* out,
+                                     size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const int16x8_t v = vld1q_s16(in + i);
+        const int16x8x2_t dup{v, v};
+        vst2q_s16(out + 2 * i, dup);
+    }
+    duplicate_to_stereo_scalar(in + i, out + 2 * i, frames - i);
+}
+#endif
+
+// Bounded lock-free SPSC ring handing encoded packets from the
+// encode loop to the writer thread, same shape as the spectrum
+// sample's: push spins when full (encoder got ahead of the disk),
+// pop spins when empty; finish() releases the final drain, after
+// which pop() returns nullptr.
+class PacketRing final {
+public:
+    static constexpr size_t kDepth = 64; // power of two
+
+    void push(AVPacket* pkt) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        while (head - tail_.load(std::memory_order_acquire) >= kDepth) {
+            std::this_thread::yield();
+        }
+        slots_[head & (kDepth - 1)] = pkt;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    AVPacket* pop() {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        while (tail == head_.load(std::memory_order_acquire)) {
+            if (done_.load(std::memory_order_acquire) &&
+                tail == head_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+        AVPacket* pkt = slots_[tail & (kDepth - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return pkt;
+    }
+
+    void finish() { done_.store(true, std::memory_order_release); }
+
+private:
+    std::array<AVPacket*, kDepth> slots_{};
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::atomic<bool> done_{false};
+};
+
 void print_usage(std::string_view prog_name) {
     std::cout << std::format("Usage: {} <input> <output> [options]\n\n", prog_name);
     std::cout << "Operations:\n";
@@ -263,6 +725,11 @@ public:
     void process() {
         print_processing_info();
 
+        if (raw_wav_path_usable()) {
+            process_raw_wav();
+            return;
+        }
+
         // Determine output format
         auto output_codec_id = (params_.operation == StereoOperation::TO_MONO) ?
                                AV_CODEC_ID_PCM_S16LE : AV_CODEC_ID_PCM_S16LE;
@@ -325,60 +792,106 @@ public:
             "write output header"
         );
 
+        // Muxing runs on its own thread so the output file's write()
+        // syscalls overlap the decode/transform of the next frame;
+        // the ring bounds in-flight packets. Write errors are
+        // latched and re-raised after the join.
+        std::thread writer([this] {
+            while (AVPacket* pkt = write_queue_.pop()) {
+                if (write_status_.load(std::memory_order_relaxed) == 0) {
+                    const auto ret = av_interleaved_write_frame(
+                        output_format_ctx_.get(), pkt);
+                    if (ret < 0) {
+                        write_status_.store(ret, std::memory_order_relaxed);
+                    }
+                }
+                av_packet_free(&pkt);
+            }
+        });
+
         // Process audio
         std::cout << "\nProcessing...\n";
         int64_t samples_processed = 0;
-        int iteration = 0;
 
-        // Decode, filter, and encode
-        while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
-            if (packet_->stream_index == audio_stream_index_) {
-                ffmpeg::check_error(
-                    avcodec_send_packet(decoder_ctx_.get(), packet_.get()),
-                    "send packet to decoder"
-                );
+        try {
 
-                while (avcodec_receive_frame(decoder_ctx_.get(), frame_.get()) >= 0) {
-                    // Push frame to filter
+            // Decode, filter, and encode
+            while (av_read_frame(format_ctx_.get(), packet_.get()) >= 0) {
+                if (packet_->stream_index == audio_stream_index_) {
                     ffmpeg::check_error(
-                        av_buffersrc_add_frame_flags(buffersrc_ctx_, frame_.get(),
-                                                    AV_BUFFERSRC_FLAG_KEEP_REF),
-                        "feed filter graph"
+                        avcodec_send_packet(decoder_ctx_.get(), packet_.get()),
+                        "send packet to decoder"
                     );
 
-                    // Pull filtered frames
-                    while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
-                        // Encode filtered frame
-                        encode_and_write_frame(filtered_frame_.get());
-                        samples_processed += filtered_frame_->nb_samples;
-                        av_frame_unref(filtered_frame_.get());
-
-                        ++iteration;
-                        if (iteration % 100 == 0) {
-                            const auto seconds = samples_processed /
-                                               static_cast<double>(decoder_ctx_->sample_rate);
-                            std::cout << std::format("Processed: {:.2f}s\r", seconds)
-                                     << std::flush;
+                    while (avcodec_receive_frame(decoder_ctx_.get(), frame_.get()) >= 0) {
+                        if (use_simd_path_) {
+                            // Transform the decoded buffer directly; no
+                            // filter graph round trip
+                            auto* out = transform_frame_simd();
+                            out->pts = samples_processed;
+                            encode_and_write_frame(out);
+                            samples_processed += out->nb_samples;
+                            if (out != frame_.get()) {
+                                av_frame_unref(out);
+                            }
+                            report_progress(samples_processed);
+                            continue;
+                        }
+
+                        // Push frame to filter; the graph takes
+                        // ownership of the reference -- nothing reads
+                        // the frame afterwards, so KEEP_REF would only
+                        // add a ref/unref pair per frame
+                        ffmpeg::check_error(
+                            av_buffersrc_add_frame_flags(buffersrc_ctx_, frame_.get(), 0),
+                            "feed filter graph"
+                        );
+
+                        // Pull filtered frames
+                        while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
+                            // Encode filtered frame
+                            encode_and_write_frame(filtered_frame_.get());
+                            samples_processed += filtered_frame_->nb_samples;
+                            av_frame_unref(filtered_frame_.get());
+
+                            report_progress(samples_processed);
                         }
                     }
                 }
+                av_packet_unref(packet_.get());
             }
-            av_packet_unref(packet_.get());
-        }
 
-        // Flush filter graph
-        ffmpeg::check_error(
-            av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0),
-            "flush filter graph"
-        );
+            // Flush filter graph (the SIMD path has no buffered state)
+            if (!use_simd_path_) {
+                ffmpeg::check_error(
+                    av_buffersrc_add_frame_flags(buffersrc_ctx_, nullptr, 0),
+                    "flush filter graph"
+                );
+
+                while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
+                    encode_and_write_frame(filtered_frame_.get());
+                    av_frame_unref(filtered_frame_.get());
+                }
+            }
 
-        while (av_buffersink_get_frame(buffersink_ctx_, filtered_frame_.get()) >= 0) {
-            encode_and_write_frame(filtered_frame_.get());
-            av_frame_unref(filtered_frame_.get());
+            // Flush encoder
+            flush_encoder();
+        } catch (...) {
+            // Release the writer before unwinding so a decode or
+            // encode error surfaces as the usual Error: exit instead
+            // of std::terminate on a joinable thread, and every
+            // in-flight packet is drained and freed exactly once
+            write_queue_.finish();
+            writer.join();
+            throw;
         }
 
-        // Flush encoder
-        flush_encoder();
+        // Drain the ring before the trailer so every packet is on
+        // disk, then surface any write error from the muxing thread
+        write_queue_.finish();
+        writer.join();
+        ffmpeg::check_error(write_status_.load(std::memory_order_relaxed),
+                            "write frame");
 
         // Write trailer
         ffmpeg::check_error(
@@ -398,6 +911,106 @@ public:
     }
 
 private:
+    // Swap and phase-invert on s16le WAV input are pure byte
+    // transforms of the data chunk -- no decode, no encode, no
+    // remux needed
+    [[nodiscard]] bool raw_wav_path_usable() const {
+        if (!use_simd_path_) {
+            return false;
+        }
+        if (params_.operation != StereoOperation::SWAP_CHANNELS &&
+            params_.operation != StereoOperation::PHASE_INVERT) {
+            return false;
+        }
+        if (decoder_ctx_->codec_id != AV_CODEC_ID_PCM_S16LE) {
+            return false;
+        }
+        return format_ctx_->iformat &&
+               std::string_view{format_ctx_->iformat->name} == "wav";
+    }
+
+    // Stream the WAV file through the kernel in 1 MiB blocks: every
+    // chunk is copied verbatim except the data payload, which is
+    // transformed in place on the way through. 1 MiB is a multiple
+    // of the 4-byte stereo frame, so block edges never split a frame.
+    void process_raw_wav() {
+        std::cout << "\nProcessing (raw WAV fast path)...\n";
+
+        std::ifstream in(input_file_, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error(std::format("Failed to open input: {}",
+                                                 input_file_.string()));
+        }
+        std::ofstream out(output_file_, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error(std::format("Failed to open output: {}",
+                                                 output_file_.string()));
+        }
+
+        char riff_header[12];
+        in.read(riff_header, sizeof(riff_header));
+        if (in.gcount() != sizeof(riff_header) ||
+            std::memcmp(riff_header, "RIFF", 4) != 0 ||
+            std::memcmp(riff_header + 8, "WAVE", 4) != 0) {
+            throw std::runtime_error("Not a RIFF/WAVE file");
+        }
+        out.write(riff_header, sizeof(riff_header));
+
+        std::vector<char> buf(1 << 20);
+        int64_t data_frames = 0;
+        char chunk_header[8];
+
+        while (in.read(chunk_header, sizeof(chunk_header))) {
+            out.write(chunk_header, sizeof(chunk_header));
+
+            uint32_t chunk_size = 0;
+            std::memcpy(&chunk_size, chunk_header + 4, sizeof(chunk_size));
+            const bool is_data =
+                std::memcmp(chunk_header, "data", 4) == 0;
+
+            uint64_t remaining = chunk_size;
+            while (remaining > 0) {
+                in.read(buf.data(),
+                        static_cast<std::streamsize>(
+                            std::min<uint64_t>(remaining, buf.size())));
+                const auto got = in.gcount();
+                if (got <= 0) {
+                    break;
+                }
+
+                if (is_data) {
+                    auto* samples = reinterpret_cast<int16_t*>(buf.data());
+                    const auto frames = static_cast<size_t>(got) / 4;
+                    if (params_.operation == StereoOperation::SWAP_CHANNELS) {
+                        swap_fn_(samples, frames);
+                    } else if (params_.invert_left || params_.invert_right) {
+                        invert_fn_(samples, frames, params_.invert_left,
+                                   params_.invert_right);
+                    }
+                    data_frames += static_cast<int64_t>(frames);
+                }
+
+                out.write(buf.data(), got);
+                remaining -= static_cast<uint64_t>(got);
+            }
+
+            // RIFF chunks are word-aligned; carry the pad byte over
+            if (chunk_size & 1) {
+                char pad = 0;
+                if (in.read(&pad, 1)) {
+                    out.write(&pad, 1);
+                }
+            }
+        }
+
+        const auto total_seconds =
+            data_frames / static_cast<double>(decoder_ctx_->sample_rate);
+
+        std::cout << std::format("\nProcessing completed!\n");
+        std::cout << std::format("Duration: {:.2f} seconds\n", total_seconds);
+        std::cout << std::format("Output: {}\n", output_file_.string());
+    }
+
     void initialize() {
         // Find audio stream
         const auto stream_idx = ffmpeg::find_stream_index(format_ctx_.get(),
@@ -424,8 +1037,183 @@ private:
             "open decoder"
         );
 
-        // Setup filter graph
-        setup_filter_graph();
+        // Linear ops on packed s16 run in-process; everything else
+        // (and every other decoder output format) keeps the graph
+        use_simd_path_ = simd_path_usable();
+        if (use_simd_path_) {
+            setup_simd_coefficients();
+            select_kernel_tier();
+        } else {
+            setup_filter_graph();
+        }
+    }
+
+    // Bind the kernel tier once, ff_audio_mix_init style: the inner
+    // loop then calls straight through function pointers with no
+    // per-frame feature checks
+    void select_kernel_tier() {
+#if defined(__x86_64__) || defined(__i386__)
+        const int flags = av_get_cpu_flags();
+        if (flags & AV_CPU_FLAG_AVX2) {
+            matrix_fn_ = stereo_matrix_s16_avx2;
+            swap_fn_ = swap_channels_s16_avx2;
+            invert_fn_ = invert_phase_s16_avx2;
+            dup_fn_ = duplicate_to_stereo_avx2;
+            mono_fn_ = downmix_to_mono_avx2;
+        } else if (flags & AV_CPU_FLAG_SSE2) {
+            matrix_fn_ = stereo_matrix_s16_sse2;
+            swap_fn_ = swap_channels_s16_sse2;
+            invert_fn_ = invert_phase_s16_sse2;
+            dup_fn_ = duplicate_to_stereo_sse2;
+            mono_fn_ = downmix_to_mono_sse2;
+        }
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+        matrix_fn_ = stereo_matrix_s16_neon;
+        swap_fn_ = swap_channels_s16_neon;
+        invert_fn_ = invert_phase_s16_neon;
+        dup_fn_ = duplicate_to_stereo_neon;
+        mono_fn_ = downmix_to_mono_neon;
+#endif
+    }
+
+    [[nodiscard]] bool simd_path_usable() const {
+        if (decoder_ctx_->sample_fmt != AV_SAMPLE_FMT_S16) {
+            return false;
+        }
+
+        const int channels = decoder_ctx_->ch_layout.nb_channels;
+        switch (params_.operation) {
+            case StereoOperation::TO_STEREO:
+                return channels == 1;
+            case StereoOperation::TO_MONO:
+            case StereoOperation::WIDTH:
+            case StereoOperation::SWAP_CHANNELS:
+            case StereoOperation::MID_SIDE:
+            case StereoOperation::BALANCE:
+            case StereoOperation::PHASE_INVERT:
+                return channels == 2;
+            default:
+                return false;
+        }
+    }
+
+    void setup_simd_coefficients() {
+        const auto to_q12 = [](double v) {
+            return static_cast<int16_t>(std::clamp<long>(
+                std::lround(v * 4096.0), INT16_MIN, INT16_MAX));
+        };
+
+        if (params_.operation == StereoOperation::WIDTH) {
+            // Classic width matrix: decompose to mid/side, scale the
+            // side by w, recompose --
+            // L' = 0.5(1+w)L + 0.5(1-w)R, R' symmetric. w=0 is mono,
+            // w=1 identity, w=2 doubled side level
+            const double w = params_.width;
+            a00_ = to_q12(0.5 * (1.0 + w));
+            a01_ = to_q12(0.5 * (1.0 - w));
+            a10_ = to_q12(0.5 * (1.0 - w));
+            a11_ = to_q12(0.5 * (1.0 + w));
+        } else if (params_.operation == StereoOperation::MID_SIDE) {
+            // Same matrix the pan spec encoded:
+            // L' = m*L + s*R, R' = m*L - s*R
+            const auto mid = std::pow(10.0, params_.mid_gain / 20.0);
+            const auto side = std::pow(10.0, params_.side_gain / 20.0);
+            a00_ = to_q12(mid);
+            a01_ = to_q12(side);
+            a10_ = to_q12(mid);
+            a11_ = to_q12(-side);
+        } else if (params_.operation == StereoOperation::BALANCE) {
+            const double left_gain =
+                params_.balance > 0 ? 1.0 - params_.balance : 1.0;
+            const double right_gain =
+                params_.balance < 0 ? 1.0 + params_.balance : 1.0;
+            a00_ = to_q12(left_gain);
+            a01_ = 0;
+            a10_ = 0;
+            a11_ = to_q12(right_gain);
+        }
+    }
+
+    // Run the selected linear op on the decoded frame. In-place for
+    // the stereo-to-stereo ops; TO_STEREO writes into a fresh stereo
+    // frame since the channel count changes.
+    AVFrame* transform_frame_simd() {
+        if (params_.operation == StereoOperation::TO_STEREO ||
+            params_.operation == StereoOperation::TO_MONO) {
+            // Channel count changes, so these write a fresh frame
+            // with the encoder's layout
+            filtered_frame_->nb_samples = frame_->nb_samples;
+            filtered_frame_->format = AV_SAMPLE_FMT_S16;
+            filtered_frame_->sample_rate = frame_->sample_rate;
+            ffmpeg::check_error(
+                av_channel_layout_copy(&filtered_frame_->ch_layout,
+                                       &encoder_ctx_->ch_layout),
+                "copy channel layout"
+            );
+            ffmpeg::check_error(
+                av_frame_get_buffer(filtered_frame_.get(), 0),
+                "allocate output frame"
+            );
+
+            const auto* in = reinterpret_cast<const int16_t*>(frame_->data[0]);
+            auto* out = reinterpret_cast<int16_t*>(filtered_frame_->data[0]);
+            const auto frames = static_cast<size_t>(frame_->nb_samples);
+            if (params_.operation == StereoOperation::TO_MONO) {
+                mono_fn_(in, out, frames);
+            } else {
+                dup_fn_(in, out, frames);
+            }
+            return filtered_frame_.get();
+        }
+
+        ffmpeg::check_error(av_frame_make_writable(frame_.get()),
+                            "make frame writable");
+        auto* samples = reinterpret_cast<int16_t*>(frame_->data[0]);
+        const auto frames = static_cast<size_t>(frame_->nb_samples);
+
+        switch (params_.operation) {
+            case StereoOperation::SWAP_CHANNELS:
+                swap_fn_(samples, frames);
+                break;
+
+            case StereoOperation::PHASE_INVERT:
+                if (params_.invert_left || params_.invert_right) {
+                    invert_fn_(samples, frames, params_.invert_left,
+                               params_.invert_right);
+                }
+                break;
+
+            default: // WIDTH / MID_SIDE / BALANCE: 2x2 matrix
+                matrix_fn_(samples, frames, a00_, a01_, a10_, a11_);
+                break;
+        }
+        return frame_.get();
+    }
+
+    // Interactive-only, wall-clock throttled progress line: the
+    // frame-count modulus scaled with codec frame size, so short
+    // frames (AAC, Opus) fired format+flush thousands of times per
+    // second. 100ms is faster than anyone reads, independent of
+    // frame size, and the \r overwrite is noise in redirected logs.
+    void report_progress(int64_t samples_processed) {
+        static const bool is_tty = isatty(fileno(stdout)) != 0;
+        if (!is_tty) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_progress_ < std::chrono::milliseconds(100)) {
+            return;
+        }
+        last_progress_ = now;
+        // Stack-format and write(2) directly: no heap string, no
+        // stream lock, and nothing ahead of the line to flush
+        char buf[64];
+        const auto res = std::format_to_n(
+            buf, sizeof(buf), "Processed: {:.2f}s\r",
+            samples_processed /
+                static_cast<double>(decoder_ctx_->sample_rate));
+        [[maybe_unused]] const ssize_t n =
+            ::write(STDOUT_FILENO, buf, static_cast<size_t>(res.size));
     }
 
     void setup_filter_graph() {
@@ -502,34 +1290,42 @@ private:
             "send frame to encoder"
         );
 
-        auto out_packet = ffmpeg::create_packet();
-        while (avcodec_receive_packet(encoder_ctx_.get(), out_packet.get()) >= 0) {
-            out_packet->stream_index = 0;
-            av_packet_rescale_ts(out_packet.get(),
+        // Each received packet moves to the writer thread, which
+        // frees it after muxing
+        for (;;) {
+            AVPacket* pkt = av_packet_alloc();
+            if (!pkt) {
+                ffmpeg::check_error(AVERROR(ENOMEM), "allocate packet");
+            }
+            if (avcodec_receive_packet(encoder_ctx_.get(), pkt) < 0) {
+                av_packet_free(&pkt);
+                break;
+            }
+            pkt->stream_index = 0;
+            av_packet_rescale_ts(pkt,
                                encoder_ctx_->time_base,
                                output_format_ctx_->streams[0]->time_base);
-
-            ffmpeg::check_error(
-                av_interleaved_write_frame(output_format_ctx_.get(), out_packet.get()),
-                "write frame"
-            );
-
-            av_packet_unref(out_packet.get());
+            write_queue_.push(pkt);
         }
     }
 
     void flush_encoder() {
         avcodec_send_frame(encoder_ctx_.get(), nullptr);
 
-        auto out_packet = ffmpeg::create_packet();
-        while (avcodec_receive_packet(encoder_ctx_.get(), out_packet.get()) >= 0) {
-            out_packet->stream_index = 0;
-            av_packet_rescale_ts(out_packet.get(),
+        for (;;) {
+            AVPacket* pkt = av_packet_alloc();
+            if (!pkt) {
+                ffmpeg::check_error(AVERROR(ENOMEM), "allocate packet");
+            }
+            if (avcodec_receive_packet(encoder_ctx_.get(), pkt) < 0) {
+                av_packet_free(&pkt);
+                break;
+            }
+            pkt->stream_index = 0;
+            av_packet_rescale_ts(pkt,
                                encoder_ctx_->time_base,
                                output_format_ctx_->streams[0]->time_base);
-
-            av_interleaved_write_frame(output_format_ctx_.get(), out_packet.get());
-            av_packet_unref(out_packet.get());
+            write_queue_.push(pkt);
         }
     }
 
@@ -589,6 +1385,24 @@ private:
     AVFilterContext* buffersrc_ctx_ = nullptr;
     AVFilterContext* buffersink_ctx_ = nullptr;
     int audio_stream_index_ = -1;
+
+    bool use_simd_path_ = false;
+    int16_t a00_ = 0, a01_ = 0, a10_ = 0, a11_ = 0;
+
+    // Kernel tier, bound once in select_kernel_tier()
+    void (*matrix_fn_)(int16_t*, size_t, int16_t, int16_t, int16_t,
+                       int16_t) = stereo_matrix_s16_scalar;
+    void (*swap_fn_)(int16_t*, size_t) = swap_channels_s16_scalar;
+    void (*invert_fn_)(int16_t*, size_t, bool, bool) =
+        invert_phase_s16_scalar;
+    void (*dup_fn_)(const int16_t*, int16_t*, size_t) =
+        duplicate_to_stereo_scalar;
+    void (*mono_fn_)(const int16_t*, int16_t*, size_t) =
+        downmix_to_mono_scalar;
+
+    PacketRing write_queue_;
+    std::atomic<int> write_status_{0};
+    std::chrono::steady_clock::time_point last_progress_{};
 };
 
 } // anonymous namespace